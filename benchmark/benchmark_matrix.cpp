@@ -4,7 +4,29 @@
 #include <matrix_operations/matrix_util.h>
 #include <matrix_operations/thread_pool.h>
 #include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <cstdint>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 #include <matrix_operations/matrix_impl_2.h>
+#include <matrix_operations/block_sparse_matrix.h>
+#include <matrix_operations/matrix_graph.h>
+#include <matrix_operations/allocator.h>
+#include <matrix_operations/packed_matrix.h>
+#include <matrix_operations/incremental_product.h>
+#include <matrix_operations/streaming_gram.h>
+#include <matrix_operations/syrk.h>
+#include <matrix_operations/lu.h>
+#include <matrix_operations/cholesky.h>
+#include <matrix_operations/matrix_power.h>
+#include <matrix_operations/semiring.h>
+#include <matrix_operations/bit_matrix.h>
+#include <matrix_operations/complex_matrix.h>
 
 
 template <typename MatrixType>
@@ -113,6 +135,51 @@ using MatrixFixture22048 = MatrixFixture2<matrix_tiled::Matrix<2048, 2048>>;
     BenchmarkTemplateMatrix2(ClassName##256, FunctionName);     \
     BenchmarkTemplateMatrix2(ClassName##512, FunctionName);
 
+//////////////////////////////////////////////////////////////////////
+/* Banded (tridiagonal in tiles) operands for the block sparse tiled matrix */
+template <typename MatrixType>
+class MatrixFixture3 : public benchmark::Fixture
+{
+public:
+    using SparseType = matrix_tiled::BlockSparseMatrixImpl<double, MatrixType::rows(), MatrixType::columns()>;
+
+    void SetUp(::benchmark::State &state) override
+    {
+        fill_matrix2<double>(m1);
+        fill_matrix2<double>(m2);
+        for (std::size_t r = 0; r < m1.rows(); r++)
+        {
+            for (std::size_t c = 0; c < m1.columns(); c++)
+            {
+                if ((r > c ? r - c : c - r) >= MatrixType::BlockSize)
+                {
+                    m1.data_row_column(r, c) = 0;
+                    m2.data_row_column(r, c) = 0;
+                }
+            }
+        }
+        s1 = SparseType{m1};
+        s2 = SparseType{m2};
+    }
+
+    void TearDown(::benchmark::State &state) override
+    {
+    }
+
+    MatrixType m1{};
+    MatrixType m2{};
+    SparseType s1{};
+    SparseType s2{};
+};
+
+using MatrixFixture38 = MatrixFixture3<matrix_tiled::Matrix<8, 8>>;
+using MatrixFixture316 = MatrixFixture3<matrix_tiled::Matrix<16, 16>>;
+using MatrixFixture332 = MatrixFixture3<matrix_tiled::Matrix<32, 32>>;
+using MatrixFixture364 = MatrixFixture3<matrix_tiled::Matrix<64, 64>>;
+using MatrixFixture3128 = MatrixFixture3<matrix_tiled::Matrix<128, 128>>;
+using MatrixFixture3256 = MatrixFixture3<matrix_tiled::Matrix<256, 256>>;
+using MatrixFixture3512 = MatrixFixture3<matrix_tiled::Matrix<512, 512>>;
+
 //////////////////////////////////////////////////////////////////////
 /* benchmark matrix multiplication */
 
@@ -152,6 +219,30 @@ static void matrix_multiplication_tiled(Fixture &fixture, benchmark::State &stat
 
 BenchmarkTemplateMatrixForAll2(MatrixFixture2, matrix_multiplication_tiled);
 
+template <typename Fixture>
+static void matrix_multiplication_banded_tiled(Fixture &fixture, benchmark::State &state)
+{
+    for (auto _ : state)
+    {
+        auto m = fixture.m1.multiplication_tiled(fixture.m2);
+        benchmark::DoNotOptimize(m);
+    }
+}
+
+BenchmarkTemplateMatrixForAll2(MatrixFixture3, matrix_multiplication_banded_tiled);
+
+template <typename Fixture>
+static void matrix_multiplication_banded_block_sparse(Fixture &fixture, benchmark::State &state)
+{
+    for (auto _ : state)
+    {
+        auto m = fixture.s1.multiplication_tiled(fixture.s2);
+        benchmark::DoNotOptimize(m);
+    }
+}
+
+BenchmarkTemplateMatrixForAll2(MatrixFixture3, matrix_multiplication_banded_block_sparse);
+
 template <typename Fixture>
 static void matrix_multiplication_blocked(Fixture &fixture, benchmark::State &state)
 {
@@ -300,4 +391,579 @@ static void BM_ab_c(Fixture &fixture, benchmark::State &state)
 
 BenchmarkTemplateMatrixForAll(MatrixFixture, BM_ab_c);
 
+/* Matrix-Vector */
+template <std::size_t N>
+class MatrixVectorFixture : public benchmark::Fixture
+{
+public:
+    void SetUp(::benchmark::State &state) override
+    {
+        fill_matrix<double>(m1);
+        fill_matrix<double>(x);
+        fill_matrix<double>(xs);
+    }
+
+    void TearDown(::benchmark::State &state) override
+    {
+    }
+
+    Matrix<N, N> m1{};
+    Matrix<N, 1> x{};
+    /* 8 vectors, one per row */
+    Matrix<8, N> xs{};
+};
+
+using MatrixVectorFixture8 = MatrixVectorFixture<8>;
+using MatrixVectorFixture16 = MatrixVectorFixture<16>;
+using MatrixVectorFixture32 = MatrixVectorFixture<32>;
+using MatrixVectorFixture64 = MatrixVectorFixture<64>;
+using MatrixVectorFixture128 = MatrixVectorFixture<128>;
+using MatrixVectorFixture256 = MatrixVectorFixture<256>;
+using MatrixVectorFixture512 = MatrixVectorFixture<512>;
+using MatrixVectorFixture1024 = MatrixVectorFixture<1024>;
+using MatrixVectorFixture2048 = MatrixVectorFixture<2048>;
+
+template <typename Fixture>
+static void matrix_vector_multiplication_t1(Fixture &fixture, benchmark::State &state)
+{
+    for (auto _ : state)
+    {
+        auto m = fixture.m1.multiplication_t1(fixture.x);
+        benchmark::DoNotOptimize(m);
+    }
+}
+
+BenchmarkTemplateMatrixForAll_BIG(MatrixVectorFixture, matrix_vector_multiplication_t1);
+
+template <typename Fixture>
+static void matrix_vector_gemv_t1(Fixture &fixture, benchmark::State &state)
+{
+    for (auto _ : state)
+    {
+        auto m = gemv_t1(fixture.m1, fixture.x);
+        benchmark::DoNotOptimize(m);
+    }
+}
+
+BenchmarkTemplateMatrixForAll_BIG(MatrixVectorFixture, matrix_vector_gemv_t1);
+
+template <typename Fixture>
+static void matrix_vector_gemv_batched_t1(Fixture &fixture, benchmark::State &state)
+{
+    for (auto _ : state)
+    {
+        auto m = gemv_batched_t1(fixture.m1, fixture.xs);
+        benchmark::DoNotOptimize(m);
+    }
+}
+
+BenchmarkTemplateMatrixForAll_BIG(MatrixVectorFixture, matrix_vector_gemv_batched_t1);
+
+/* Hardware event counter of the calling thread (perf_event_open), user space only. */
+/* valid() is false where perf events are not available, e.g. in most containers and VMs. */
+class PerfCounter
+{
+public:
+    PerfCounter(std::uint32_t type, std::uint64_t config)
+    {
+        perf_event_attr attr{};
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd_ = static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+    PerfCounter(const PerfCounter &) = delete;
+    ~PerfCounter()
+    {
+        if (fd_ >= 0)
+            ::close(fd_);
+    }
+
+    [[nodiscard]] bool valid() const noexcept { return fd_ >= 0; }
+    void start() const noexcept
+    {
+        ::ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+        ::ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+    }
+    [[nodiscard]] std::uint64_t stop() const noexcept
+    {
+        ::ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+        std::uint64_t count{0};
+        return ::read(fd_, &count, sizeof(count)) == static_cast<ssize_t>(sizeof(count)) ? count : 0;
+    }
+
+private:
+    int fd_{-1};
+};
+
+inline PerfCounter dtlb_load_misses()
+{
+    return PerfCounter{PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)};
+}
+
+/* Operands and result on the heap with the given page size (allocator.h) */
+template <std::size_t N, memory::Pages P>
+class PagedMatrixFixture : public benchmark::Fixture
+{
+public:
+    void SetUp(::benchmark::State &state) override
+    {
+        m1 = memory::make_matrix<Matrix<N, N>>(P);
+        m2 = memory::make_matrix<Matrix<N, N>>(P);
+        r = memory::make_matrix<Matrix<N, N>>(P);
+        fill_matrix<double>(*m1);
+        fill_matrix<double>(*m2);
+    }
+
+    void TearDown(::benchmark::State &state) override
+    {
+        m1.reset();
+        m2.reset();
+        r.reset();
+    }
+
+    memory::MatrixPtr<Matrix<N, N>> m1{};
+    memory::MatrixPtr<Matrix<N, N>> m2{};
+    memory::MatrixPtr<Matrix<N, N>> r{};
+};
+
+using PagedMatrixFixture1024 = PagedMatrixFixture<1024, memory::Pages::normal>;
+using PagedMatrixFixture2048 = PagedMatrixFixture<2048, memory::Pages::normal>;
+using PagedMatrixFixtureHuge1024 = PagedMatrixFixture<1024, memory::Pages::transparent_huge>;
+using PagedMatrixFixtureHuge2048 = PagedMatrixFixture<2048, memory::Pages::transparent_huge>;
+
+/* R = A . B single threaded, reports dTLB load misses per iteration if the counter is available */
+template <typename Fixture>
+static void paged_multiplication_t1(Fixture &fixture, benchmark::State &state)
+{
+    auto counter = dtlb_load_misses();
+    std::uint64_t misses{0};
+    for (auto _ : state)
+    {
+        for (auto &row : fixture.r->data())
+        {
+            row.fill(0.0);
+        }
+        if (counter.valid())
+            counter.start();
+        fixture.m1->multiplication_t_aux(*fixture.r, *fixture.m2, 0, fixture.m1->rows());
+        if (counter.valid())
+            misses += counter.stop();
+        benchmark::DoNotOptimize(*fixture.r);
+    }
+    if (counter.valid())
+        state.counters["dtlb_misses"] = benchmark::Counter(static_cast<double>(misses), benchmark::Counter::kAvgIterations);
+}
+
+BenchmarkTemplateMatrix(PagedMatrixFixture1024, paged_multiplication_t1);
+BenchmarkTemplateMatrix(PagedMatrixFixtureHuge1024, paged_multiplication_t1);
+BenchmarkTemplateMatrix(PagedMatrixFixture2048, paged_multiplication_t1);
+BenchmarkTemplateMatrix(PagedMatrixFixtureHuge2048, paged_multiplication_t1);
+
+/* The same B multiplied by a new A every iteration, packed once in SetUp */
+template <typename Fixture>
+static void matrix_multiplication_packed(Fixture &fixture, benchmark::State &state)
+{
+    const PackedMatrix packed{fixture.m2, static_cast<Packing>(state.range(0))};
+    for (auto _ : state)
+    {
+        auto m = multiplication(fixture.m1, packed, execution::serial);
+        benchmark::DoNotOptimize(m);
+    }
+}
+
+template <typename Fixture>
+static void matrix_multiplication_unpacked(Fixture &fixture, benchmark::State &state)
+{
+    for (auto _ : state)
+    {
+        auto m = fixture.m1.multiplication(fixture.m2, execution::serial);
+        benchmark::DoNotOptimize(m);
+    }
+}
+
+BENCHMARK_DEFINE_F(MatrixFixture256, BM_matrix_multiplication_packed)
+(benchmark::State &state) { matrix_multiplication_packed(*this, state); }
+BENCHMARK_REGISTER_F(MatrixFixture256, BM_matrix_multiplication_packed)->Arg(static_cast<int>(Packing::panels))->Arg(static_cast<int>(Packing::transposed));
+BenchmarkTemplateMatrix(MatrixFixture256, matrix_multiplication_unpacked);
+
+/* A tick changes 4 rows of A and 16 elements of C, R = A . B + C is updated incrementally */
+template <typename Fixture>
+static void ab_c_incremental_tick(Fixture &fixture, benchmark::State &state)
+{
+    IncrementalProduct product{fixture.m1, fixture.m2, fixture.m3, execution::serial};
+    std::size_t tick{0};
+    for (auto _ : state)
+    {
+        for (std::size_t n = 0; n < 4; n++)
+        {
+            const auto i = (tick * 4 + n) % fixture.m1.rows();
+            product.set_a_row(i, fixture.m2.data()[i]);
+        }
+        for (std::size_t n = 0; n < 16; n++)
+        {
+            product.set_c(n, tick % fixture.m3.columns(), static_cast<double>(tick));
+        }
+        product.update(execution::serial);
+        benchmark::DoNotOptimize(product.result());
+        tick++;
+    }
+}
+
+BenchmarkTemplateMatrix(MatrixFixture256, ab_c_incremental_tick);
+
+/* Rows of width 64 entering a window of 1024 rows, state.range(0) rows per tick */
+static void streaming_gram_tick(benchmark::State &state)
+{
+    static Matrix<1024, 64> stream{};
+    fill_matrix<double>(stream);
+    const auto batch = static_cast<std::size_t>(state.range(0));
+    StreamingGram<double, 64> gram{1024};
+    gram.push(stream.data()[0].data(), 1024);
+    std::size_t row{0};
+    for (auto _ : state)
+    {
+        gram.push(stream.data()[row].data(), batch);
+        row = (row + batch) % (1024 - batch);
+        benchmark::DoNotOptimize(gram);
+    }
+    state.counters["rows"] = benchmark::Counter(static_cast<double>(state.iterations() * batch), benchmark::Counter::kIsRate);
+}
+BENCHMARK(streaming_gram_tick)->Arg(1)->Arg(16);
+
+/* The same window recomputed from scratch every tick */
+static void streaming_gram_recompute(benchmark::State &state)
+{
+    static Matrix<1024, 64> stream{};
+    fill_matrix<double>(stream);
+    StreamingGram<double, 64> gram{1024};
+    gram.push(stream.data()[0].data(), 1024);
+    for (auto _ : state)
+    {
+        gram.recompute();
+        benchmark::DoNotOptimize(gram);
+    }
+}
+BENCHMARK(streaming_gram_recompute);
+
+/* A . A^T, one triangle with SYRK against the full product with a transposed copy */
+template <typename Fixture>
+static void matrix_syrk(Fixture &fixture, benchmark::State &state)
+{
+    for (auto _ : state)
+    {
+        syrk(fixture.m3, fixture.m1, Triangle::upper, 1.0, 0.0, execution::serial);
+        benchmark::DoNotOptimize(fixture.m3);
+    }
+}
+
+template <typename Fixture>
+static void matrix_a_a_t(Fixture &fixture, benchmark::State &state)
+{
+    for (std::size_t i = 0; i < fixture.m1.rows(); i++)
+    {
+        for (std::size_t j = 0; j < fixture.m1.columns(); j++)
+        {
+            fixture.m2.data()[j][i] = fixture.m1.data()[i][j];
+        }
+    }
+    for (auto _ : state)
+    {
+        auto m = fixture.m1.multiplication(fixture.m2, execution::serial);
+        benchmark::DoNotOptimize(m);
+    }
+}
+
+BenchmarkTemplateMatrix(MatrixFixture256, matrix_syrk);
+BenchmarkTemplateMatrix(MatrixFixture256, matrix_a_a_t);
+
+/* LU factorisation of A, 2/3 n^3 flops */
+template <typename Fixture>
+static void matrix_getrf(Fixture &fixture, benchmark::State &state)
+{
+    Pivots<fixture.m1.rows()> ipiv{};
+    for (auto _ : state)
+    {
+        fixture.m3 = fixture.m1;
+        benchmark::DoNotOptimize(getrf(fixture.m3, ipiv, execution::serial));
+    }
+    const auto n = static_cast<double>(fixture.m1.rows());
+    state.counters["flops"] = benchmark::Counter(2.0 / 3.0 * n * n * n, benchmark::Counter::kIsIterationInvariantRate);
+}
+
+BenchmarkTemplateMatrix(MatrixFixture256, matrix_getrf);
+BenchmarkTemplateMatrix(MatrixFixture512, matrix_getrf);
+
+/* Cholesky factorisation of the SPD matrix A . A^T + n . I, n^3 / 3 flops */
+template <typename Fixture>
+static void matrix_potrf(Fixture &fixture, benchmark::State &state)
+{
+    const auto n = fixture.m1.rows();
+    syrk(fixture.m2, fixture.m1, Triangle::lower, 1.0, 0.0, execution::serial);
+    for (std::size_t i = 0; i < n; i++)
+    {
+        fixture.m2.data()[i][i] += static_cast<double>(n);
+    }
+    for (auto _ : state)
+    {
+        fixture.m3 = fixture.m2;
+        benchmark::DoNotOptimize(potrf(fixture.m3, execution::serial));
+    }
+    state.counters["flops"] = benchmark::Counter(1.0 / 3.0 * n * n * n, benchmark::Counter::kIsIterationInvariantRate);
+}
+
+BenchmarkTemplateMatrix(MatrixFixture256, matrix_potrf);
+BenchmarkTemplateMatrix(MatrixFixture512, matrix_potrf);
+
+/* A^16 by squaring into the workspace against 15 products with operator* style temporaries */
+template <typename Fixture>
+static void matrix_pow(Fixture &fixture, benchmark::State &state)
+{
+    PowerWorkspace<double, fixture.m1.rows()> workspace{};
+    for (auto _ : state)
+    {
+        pow(fixture.m3, fixture.m1, 16, workspace, execution::serial);
+        benchmark::DoNotOptimize(fixture.m3);
+    }
+}
+
+template <typename Fixture>
+static void matrix_pow_repeated(Fixture &fixture, benchmark::State &state)
+{
+    for (auto _ : state)
+    {
+        fixture.m3 = fixture.m1;
+        for (int i = 1; i < 16; i++)
+        {
+            fixture.m3 = fixture.m3.multiplication(fixture.m1, execution::serial);
+        }
+        benchmark::DoNotOptimize(fixture.m3);
+    }
+}
+
+BenchmarkTemplateMatrix(MatrixFixture256, matrix_pow);
+BenchmarkTemplateMatrix(MatrixFixture256, matrix_pow_repeated);
+
+/* One (min, +) product, the all pairs shortest paths step */
+template <typename Fixture>
+static void matrix_min_plus(Fixture &fixture, benchmark::State &state)
+{
+    for (auto _ : state)
+    {
+        multiply<MinPlus<double>>(fixture.m3, fixture.m1, fixture.m2, execution::serial);
+        benchmark::DoNotOptimize(fixture.m3);
+    }
+}
+
+/* The same loops over (+, *), for comparison with the ordinary product */
+template <typename Fixture>
+static void matrix_plus_times(Fixture &fixture, benchmark::State &state)
+{
+    for (auto _ : state)
+    {
+        multiply<PlusTimes<double>>(fixture.m3, fixture.m1, fixture.m2, execution::serial);
+        benchmark::DoNotOptimize(fixture.m3);
+    }
+}
+
+BenchmarkTemplateMatrix(MatrixFixture256, matrix_min_plus);
+BenchmarkTemplateMatrix(MatrixFixture256, matrix_plus_times);
+
+/* A 1024 node graph with about 1 in 16 edges, 1 bit or 1 bool per edge */
+static bool bit_benchmark_edge(std::size_t i, std::size_t j)
+{
+    return (i * 7919 + j * 104729) % 16 == 0;
+}
+
+static void bit_matrix_multiply(benchmark::State &state)
+{
+    static BitMatrix<1024, 1024> graph{};
+    static BitMatrix<1024, 1024> result{};
+    for (std::size_t i = 0; i < 1024; i++)
+    {
+        for (std::size_t j = 0; j < 1024; j++)
+            graph.set(i, j, bit_benchmark_edge(i, j));
+    }
+    for (auto _ : state)
+    {
+        multiply(result, graph, graph, execution::serial);
+        benchmark::DoNotOptimize(result);
+    }
+}
+BENCHMARK(bit_matrix_multiply);
+
+/* The same product on bools with the (or, and) semiring */
+static void bool_matrix_multiply(benchmark::State &state)
+{
+    using M = MatrixImpl<bool, 1024, 1024>;
+    auto graph = memory::make_matrix<M>();
+    auto result = memory::make_matrix<M>();
+    for (std::size_t i = 0; i < 1024; i++)
+    {
+        for (std::size_t j = 0; j < 1024; j++)
+            graph->data()[i][j] = bit_benchmark_edge(i, j);
+    }
+    for (auto _ : state)
+    {
+        multiply<OrAnd<>>(*result, *graph, *graph, execution::serial);
+        benchmark::DoNotOptimize(*result);
+    }
+}
+BENCHMARK(bool_matrix_multiply);
+
+/* 256 x 256 complex products, std::complex elements against split storage with 4M and 3M */
+static void complex_benchmark_fill(MatrixImpl<std::complex<double>, 256, 256> &m, double seed)
+{
+    for (std::size_t i = 0; i < 256; i++)
+    {
+        for (std::size_t j = 0; j < 256; j++)
+            m.data()[i][j] = {std::sin(seed + i + 0.5 * j), std::cos(seed + 0.5 * i + j)};
+    }
+}
+
+static void complex_multiplication(benchmark::State &state)
+{
+    using M = MatrixImpl<std::complex<double>, 256, 256>;
+    auto a = memory::make_matrix<M>();
+    auto b = memory::make_matrix<M>();
+    complex_benchmark_fill(*a, 1.0);
+    complex_benchmark_fill(*b, 2.0);
+    for (auto _ : state)
+    {
+        auto result = a->multiplication(*b, execution::serial);
+        benchmark::DoNotOptimize(result);
+    }
+}
+BENCHMARK(complex_multiplication);
+
+static void split_complex_multiplication(benchmark::State &state)
+{
+    using M = MatrixImpl<std::complex<double>, 256, 256>;
+    auto a = memory::make_matrix<M>();
+    auto b = memory::make_matrix<M>();
+    complex_benchmark_fill(*a, 1.0);
+    complex_benchmark_fill(*b, 2.0);
+    const SplitComplexMatrix<double, 256, 256> split_a{*a};
+    const SplitComplexMatrix<double, 256, 256> split_b{*b};
+    SplitComplexMatrix<double, 256, 256> result{};
+    ComplexWorkspace<double, 256, 256, 256> workspace{};
+    const auto method = state.range(0) == 3 ? ComplexMethod::three_m : ComplexMethod::four_m;
+    for (auto _ : state)
+    {
+        multiply(result, split_a, split_b, workspace, method, execution::serial);
+        benchmark::DoNotOptimize(result);
+    }
+}
+BENCHMARK(split_complex_multiplication)->Arg(4)->Arg(3);
+
+/* Thread pool benchmarks are registered last, the pool workers keep running once started */
+static thread_pool::ThreadPool &benchmark_pool()
+{
+    static thread_pool::ThreadPoolInstance tpi;
+    return thread_pool::ThreadPoolInstance::get_instance();
+}
+
+/* (A . B) + (C . B): two products and a sum, one fan-out/join per operation */
+template <typename Fixture>
+static void expression_sequential_pool(Fixture &fixture, benchmark::State &state)
+{
+    benchmark_pool();
+    for (auto _ : state)
+    {
+        auto m = fixture.m1.multiplication_tn_pool(fixture.m2) + fixture.m3.multiplication_tn_pool(fixture.m2);
+        benchmark::DoNotOptimize(m);
+    }
+}
+
+BenchmarkTemplateMatrixForAll(MatrixFixture, expression_sequential_pool);
+
+/* Same expression as a task graph, chunks of both products share the pool with no barrier in between */
+template <typename Fixture>
+static void expression_task_graph(Fixture &fixture, benchmark::State &state)
+{
+    auto &tp = benchmark_pool();
+    using MatrixType = decltype(fixture.m1);
+    auto ab = std::make_unique<MatrixType>();
+    auto cb = std::make_unique<MatrixType>();
+    auto r = std::make_unique<MatrixType>();
+
+    thread_pool::TaskGraph graph{};
+    auto n_ab = add_multiplication(graph, *ab, fixture.m1, fixture.m2);
+    auto n_cb = add_multiplication(graph, *cb, fixture.m3, fixture.m2);
+    add_addition(graph, *r, *ab, *cb, {n_ab, n_cb});
+
+    for (auto _ : state)
+    {
+        graph.run(tp);
+        benchmark::DoNotOptimize(*r);
+    }
+}
+
+BenchmarkTemplateMatrixForAll(MatrixFixture, expression_task_graph);
+
+/* Latency of small products while bulk products keep the pool busy, reported as p50/p99 */
+static void small_job_latency(benchmark::State &state, thread_pool::ThreadPool &tp, thread_pool::Priority priority)
+{
+    auto bulk_m = std::make_unique<Matrix<512, 512>>();
+    fill_matrix<double>(*bulk_m);
+    std::atomic<bool> stop{false};
+    std::jthread bulk([&]()
+                      {
+        while (!stop)
+        {
+            auto bulk_chunks = thread_pool::split_chunks(Matrix<512, 512>::get_chunks(), 16);
+            auto r = std::make_unique<Matrix<512, 512>>();
+            thread_pool::fork_join(tp, bulk_chunks, [&](std::size_t start, std::size_t end)
+                                   { bulk_m->multiplication_t_aux(*r, *bulk_m, start, end); });
+            benchmark::DoNotOptimize(*r);
+        } });
+
+    Matrix<32, 32> a{};
+    fill_matrix<double>(a);
+    std::vector<double> latencies{};
+    for (auto _ : state)
+    {
+        auto start = std::chrono::steady_clock::now();
+        auto m = a.multiplication_tn_pool(a, thread_pool::ForkJoin::pool_only, priority);
+        latencies.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+        benchmark::DoNotOptimize(m);
+    }
+    stop = true;
+
+    std::sort(latencies.begin(), latencies.end());
+    if (!latencies.empty())
+    {
+        state.counters["p50_us"] = latencies[latencies.size() / 2];
+        state.counters["p99_us"] = latencies[latencies.size() * 99 / 100];
+    }
+}
+
+static void small_job_latency_normal(benchmark::State &state)
+{
+    small_job_latency(state, benchmark_pool(), thread_pool::Priority::normal);
+}
+BENCHMARK(small_job_latency_normal)->UseRealTime();
+
+static void small_job_latency_high(benchmark::State &state)
+{
+    small_job_latency(state, benchmark_pool(), thread_pool::Priority::high);
+}
+BENCHMARK(small_job_latency_high)->UseRealTime();
+
+/* Two of the workers only take high priority tasks */
+static void small_job_latency_reserved(benchmark::State &state)
+{
+    static thread_pool::ThreadPool tp{};
+    if (tp.workers_.empty())
+    {
+        tp.reserve(2);
+        tp.init(8);
+    }
+    small_job_latency(state, tp, thread_pool::Priority::high);
+}
+BENCHMARK(small_job_latency_reserved)->UseRealTime();
+
 BENCHMARK_MAIN();
\ No newline at end of file
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+#include <sys/mman.h>
+
+/* Aligned and huge page backed memory for matrix storage and packing buffers. */
+/* Every buffer is cache line aligned, so SIMD loads of a row start are aligned. */
+/* Large buffers can be backed by 2 MB pages, one TLB entry then covers 512 times the */
+/* memory of a 4 KB page, which removes most dTLB misses of big matrices. */
+namespace memory
+{
+    inline constexpr std::size_t cache_line_size{64};
+    inline constexpr std::size_t huge_page_size{2 * 1024 * 1024};
+
+    enum class Pages
+    {
+        /* 4 KB pages */
+        normal,
+        /* Transparent huge pages, madvise(MADV_HUGEPAGE) on a 2 MB aligned mapping */
+        transparent_huge,
+        /* Reserved huge pages (MAP_HUGETLB), falls back to transparent_huge if none are free */
+        explicit_huge,
+    };
+
+    /* Buffers smaller than this use 4 KB pages whatever is asked for, a huge page would be mostly empty */
+    inline constexpr std::size_t huge_page_threshold{huge_page_size / 2};
+
+    namespace detail
+    {
+        constexpr std::size_t round_up(std::size_t bytes, std::size_t alignment) noexcept
+        {
+            return (bytes + alignment - 1) / alignment * alignment;
+        }
+
+        constexpr bool use_mapping(std::size_t bytes, Pages pages) noexcept
+        {
+            return pages != Pages::normal && bytes >= huge_page_threshold;
+        }
+
+        /* 2 MB aligned anonymous mapping of size bytes (a multiple of huge_page_size) */
+        inline void *map_aligned(std::size_t size) noexcept
+        {
+            const auto reserved = size + huge_page_size;
+            auto *addr = ::mmap(nullptr, reserved, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (addr == MAP_FAILED)
+                return nullptr;
+
+            /* trim the unaligned head and the tail */
+            auto *base = static_cast<char *>(addr);
+            auto *aligned = reinterpret_cast<char *>(round_up(reinterpret_cast<std::uintptr_t>(base), huge_page_size));
+            if (aligned != base)
+                ::munmap(base, static_cast<std::size_t>(aligned - base));
+            if (auto tail = static_cast<std::size_t>(base + reserved - (aligned + size)); tail > 0)
+                ::munmap(aligned + size, tail);
+            return aligned;
+        }
+    }
+
+    /* Allocate bytes, cache line aligned. Huge page backed if asked for and the buffer is large enough. */
+    /* Returns nullptr on failure. Release with deallocate and the same bytes and pages. */
+    inline void *allocate(std::size_t bytes, Pages pages = Pages::normal) noexcept
+    {
+        if (!detail::use_mapping(bytes, pages))
+            return ::operator new(detail::round_up(bytes, cache_line_size), std::align_val_t{cache_line_size}, std::nothrow);
+
+        const auto size = detail::round_up(bytes, huge_page_size);
+        if (pages == Pages::explicit_huge)
+        {
+            auto *addr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (addr != MAP_FAILED)
+                return addr;
+        }
+
+        auto *addr = detail::map_aligned(size);
+        if (addr)
+            ::madvise(addr, size, MADV_HUGEPAGE);
+        return addr;
+    }
+
+    inline void deallocate(void *ptr, std::size_t bytes, Pages pages = Pages::normal) noexcept
+    {
+        if (!ptr)
+            return;
+        if (!detail::use_mapping(bytes, pages))
+            ::operator delete(ptr, std::align_val_t{cache_line_size});
+        else
+            ::munmap(ptr, detail::round_up(bytes, huge_page_size));
+    }
+
+    /* Standard allocator over allocate / deallocate, e.g. for packing buffers */
+    template <typename T, Pages P = Pages::normal>
+    struct AlignedAllocator
+    {
+        using value_type = T;
+
+        template <typename U>
+        struct rebind
+        {
+            using other = AlignedAllocator<U, P>;
+        };
+
+        AlignedAllocator() = default;
+        template <typename U>
+        constexpr AlignedAllocator(const AlignedAllocator<U, P> &) noexcept {}
+
+        [[nodiscard]] T *allocate(std::size_t n)
+        {
+            static_assert(alignof(T) <= cache_line_size);
+            if (auto *ptr = memory::allocate(n * sizeof(T), P))
+                return static_cast<T *>(ptr);
+            throw std::bad_alloc{};
+        }
+
+        void deallocate(T *ptr, std::size_t n) noexcept
+        {
+            memory::deallocate(ptr, n * sizeof(T), P);
+        }
+
+        template <typename U>
+        constexpr bool operator==(const AlignedAllocator<U, P> &) const noexcept { return true; }
+    };
+
+    template <typename T, Pages P = Pages::normal>
+    using AlignedVector = std::vector<T, AlignedAllocator<T, P>>;
+
+    /* Destroys and releases a matrix created by make_matrix */
+    template <typename M>
+    struct MatrixDeleter
+    {
+        Pages pages{Pages::normal};
+
+        void operator()(M *m) const noexcept
+        {
+            m->~M();
+            deallocate(m, sizeof(M), pages);
+        }
+    };
+
+    template <typename M>
+    using MatrixPtr = std::unique_ptr<M, MatrixDeleter<M>>;
+
+    /* A zero initialised matrix on the heap, cache line aligned and optionally on huge pages. */
+    /* Big matrices don't fit on the stack, and the nested std::array of an automatic or */
+    /* member matrix is only aligned to alignof(T). Empty on allocation failure. */
+    template <typename M>
+    [[nodiscard]] inline MatrixPtr<M> make_matrix(Pages pages = Pages::transparent_huge)
+    {
+        static_assert(alignof(M) <= cache_line_size);
+        auto *ptr = allocate(sizeof(M), pages);
+        if (!ptr)
+            return MatrixPtr<M>{nullptr, MatrixDeleter<M>{pages}};
+        return MatrixPtr<M>{new (ptr) M{}, MatrixDeleter<M>{pages}};
+    }
+
+    template <typename T>
+    [[nodiscard]] inline bool is_aligned(const T *ptr, std::size_t alignment = cache_line_size) noexcept
+    {
+        return reinterpret_cast<std::uintptr_t>(ptr) % alignment == 0;
+    }
+}
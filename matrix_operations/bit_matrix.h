@@ -0,0 +1,221 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <matrix_operations/matrix.h>
+#include <matrix_operations/allocator.h>
+#include <matrix_operations/gemm.h>
+#include <matrix_operations/scratch_arena.h>
+
+/* Boolean matrix with one bit per element, 64 elements per word (e.g. an adjacency matrix). */
+/* The product over (or, and) uses the method of the Four Russians: for every group of 8 */
+/* rows of B a table of the 256 ors of its subsets is built, then one byte of a row of A */
+/* selects the table row to or into R, 8 elements of A per word operation. The 8 tables of */
+/* one word of A are built together, so a row of R is loaded and stored once per 64 rows of B. */
+/* The columns of R are split into blocks of bit_block_words words (8 tables of 16 KB) and */
+/* the blocks are the chunks of the policy, so no cache line of R is written by two chunks. */
+/* With fewer than 8 blocks and a parallel policy the rows of R are split as well; every */
+/* part rebuilds the tables of its block, so a part has at least bit_split_rows rows. */
+/* Rows are padded to whole blocks of 512 bits, the kernel always works on full blocks. */
+/* A 16k x 16k matrix takes 32 MB instead of 2 GB of doubles, but narrow matrices pay for */
+/* the padding: a row of 100 columns takes 64 bytes instead of 16. */
+namespace matrix
+{
+    using BitWord = std::uint64_t;
+    inline constexpr std::size_t bits_per_word{64};
+    /* Words of a row of R per table, one cache line */
+    inline constexpr std::size_t bit_block_words{8};
+    /* Rows of B per table, a byte of A */
+    inline constexpr std::size_t bit_group_rows{8};
+    /* Fewest rows of R per chunk when rows are split, building the tables of a word of A */
+    /* costs about as much as applying them to 1000 rows */
+    inline constexpr std::size_t bit_split_rows{1024};
+
+    template <std::size_t Rows, std::size_t Columns>
+    class BitMatrix
+    {
+    public:
+        static constexpr std::size_t words_per_row{(Columns + bits_per_word - 1) / bits_per_word};
+        /* rows are padded to whole blocks (up to 511 unused bits), the kernel always works on bit_block_words words */
+        static constexpr std::size_t row_stride{(words_per_row + bit_block_words - 1) / bit_block_words * bit_block_words};
+
+        /* all false */
+        BitMatrix() : data_(Rows * row_stride, BitWord{0}) {}
+        /* true for the non-zero elements of m */
+        template <typename T>
+        explicit BitMatrix(const MatrixImpl<T, Rows, Columns> &m) : BitMatrix()
+        {
+            for (std::size_t i = 0; i < Rows; i++)
+            {
+                for (std::size_t j = 0; j < Columns; j++)
+                {
+                    if (m.data()[i][j] != T{0})
+                        set(i, j);
+                }
+            }
+        }
+
+        static constexpr std::size_t rows() noexcept { return Rows; }
+        static constexpr std::size_t columns() noexcept { return Columns; }
+
+        [[nodiscard]] bool get(std::size_t i, std::size_t j) const noexcept
+        {
+            return (row(i)[j / bits_per_word] >> (j % bits_per_word)) & 1;
+        }
+        void set(std::size_t i, std::size_t j, bool value = true) noexcept
+        {
+            const auto mask = BitWord{1} << (j % bits_per_word);
+            auto &word = row(i)[j / bits_per_word];
+            word = value ? word | mask : word & ~mask;
+        }
+
+        /* row_stride words, the bits past Columns are zero */
+        [[nodiscard]] BitWord *row(std::size_t i) noexcept { return data_.data() + i * row_stride; }
+        [[nodiscard]] const BitWord *row(std::size_t i) const noexcept { return data_.data() + i * row_stride; }
+
+        void clear() noexcept { std::fill(data_.begin(), data_.end(), BitWord{0}); }
+
+        /* number of true elements */
+        [[nodiscard]] std::size_t count() const noexcept
+        {
+            std::size_t bits{0};
+            for (auto word : data_)
+            {
+                bits += static_cast<std::size_t>(std::popcount(word));
+            }
+            return bits;
+        }
+
+        /* T{1} for true and T{0} for false */
+        template <typename T>
+        void to_matrix(MatrixImpl<T, Rows, Columns> &result) const noexcept
+        {
+            for (std::size_t i = 0; i < Rows; i++)
+            {
+                for (std::size_t j = 0; j < Columns; j++)
+                {
+                    result.data()[i][j] = get(i, j) ? T{1} : T{0};
+                }
+            }
+        }
+
+        [[nodiscard]] bool operator==(const BitMatrix &other) const noexcept { return data_ == other.data_; }
+
+    private:
+        memory::AlignedVector<BitWord, memory::Pages::transparent_huge> data_;
+    };
+
+    /* R = A . B over (or, and) for the word columns [word_start, word_end) of R, multiples of */
+    /* bit_block_words, and the rows [row_start, row_end) */
+    template <std::size_t Rows, std::size_t Columns, std::size_t OtherColumns>
+    inline void bit_multiplication_aux(BitMatrix<Rows, OtherColumns> &result, const BitMatrix<Rows, Columns> &a, const BitMatrix<Columns, OtherColumns> &b, std::size_t word_start, std::size_t word_end, std::size_t row_start = 0, std::size_t row_end = Rows)
+    {
+        constexpr std::size_t table_rows{1 << bit_group_rows};
+        constexpr std::size_t tables{bits_per_word / bit_group_rows};
+        auto &arena = memory::ScratchArena::local();
+        memory::ScratchArena::Scope scope{arena};
+        auto *table = arena.allocate<BitWord>(tables * table_rows * bit_block_words);
+
+        for (std::size_t w0{word_start}; w0 < word_end; w0 += bit_block_words)
+        {
+            /* the 64 rows of B of one word of A, one table per byte */
+            for (std::size_t word = 0; word < BitMatrix<Rows, Columns>::words_per_row; word++)
+            {
+                for (std::size_t g = 0; g < tables; g++)
+                {
+                    /* t[s] = or of the rows k0 + p of B for the bits p of s */
+                    auto *t = table + g * table_rows * bit_block_words;
+                    const auto k0 = word * bits_per_word + g * bit_group_rows;
+                    std::fill_n(t, bit_block_words, BitWord{0});
+                    for (std::size_t s = 1; s < table_rows; s++)
+                    {
+                        const auto *t_rest = t + (s & (s - 1)) * bit_block_words;
+                        const auto k = k0 + static_cast<std::size_t>(std::countr_zero(s));
+                        if (k >= Columns)
+                        {
+                            std::copy_n(t_rest, bit_block_words, t + s * bit_block_words);
+                            continue;
+                        }
+                        /* a local row, the compiler can't tell t_s from b_k and would not vectorise */
+                        const auto *b_k = b.row(k) + w0;
+                        BitWord t_s[bit_block_words];
+                        for (std::size_t w = 0; w < bit_block_words; w++)
+                        {
+                            t_s[w] = t_rest[w] | b_k[w];
+                        }
+                        std::copy_n(t_s, bit_block_words, t + s * bit_block_words);
+                    }
+                }
+
+                /* r_i stays in registers for the 8 tables, no test for a zero byte */
+                /* (table row 0 is zero and the branch would be unpredictable) */
+                for (std::size_t i = row_start; i < row_end; i++)
+                {
+                    const auto a_i = a.row(i)[word];
+                    auto *r = result.row(i) + w0;
+                    BitWord r_i[bit_block_words]{};
+                    if (word > 0)
+                        std::copy_n(r, bit_block_words, r_i);
+                    for (std::size_t g = 0; g < tables; g++)
+                    {
+                        const auto s = (a_i >> (g * bit_group_rows)) & (table_rows - 1);
+                        const auto *t_s = table + (g * table_rows + s) * bit_block_words;
+                        for (std::size_t w = 0; w < bit_block_words; w++)
+                        {
+                            r_i[w] |= t_s[w];
+                        }
+                    }
+                    std::copy_n(r_i, bit_block_words, r);
+                }
+            }
+        }
+    }
+
+    /* R = A . B over (or, and), R must not be A or B */
+    template <std::size_t Rows, std::size_t Columns, std::size_t OtherColumns>
+    inline void multiply(BitMatrix<Rows, OtherColumns> &result, const BitMatrix<Rows, Columns> &a, const BitMatrix<Columns, OtherColumns> &b, const execution::Policy &policy = execution::automatic)
+    {
+        /* a chunk is a range of parts, part p is block p / row_parts and the rows of its share */
+        constexpr auto blocks = BitMatrix<Rows, OtherColumns>::row_stride / bit_block_words;
+        constexpr auto max_row_parts = std::clamp<std::size_t>((8 + blocks - 1) / blocks, 1, std::max<std::size_t>(Rows / bit_split_rows, 1));
+        const auto row_parts = execution::resolve(policy) == execution::Backend::serial || execution::nested() ? std::size_t{1} : max_row_parts;
+        execution::run(policy, even_chunks(blocks * row_parts, 8), [&result, &a, &b, row_parts](std::size_t start, std::size_t end)
+                       {
+            for (auto p = start; p < end; p++)
+            {
+                const auto block = p / row_parts;
+                const auto part = p % row_parts;
+                bit_multiplication_aux(result, a, b, block * bit_block_words, (block + 1) * bit_block_words, Rows * part / row_parts, Rows * (part + 1) / row_parts);
+            } });
+    }
+
+    template <std::size_t Rows, std::size_t Columns, std::size_t OtherColumns>
+    [[nodiscard]] inline BitMatrix<Rows, OtherColumns> operator*(const BitMatrix<Rows, Columns> &a, const BitMatrix<Columns, OtherColumns> &b)
+    {
+        BitMatrix<Rows, OtherColumns> result{};
+        multiply(result, a, b);
+        return result;
+    }
+
+    /* Reflexive transitive closure of the graph A: R(i, j) is true if j is reachable from i. */
+    /* (I | A) is squared until it does not change, at most log2(N) products. */
+    template <std::size_t N>
+    inline void transitive_closure(BitMatrix<N, N> &result, const BitMatrix<N, N> &a, const execution::Policy &policy = execution::automatic)
+    {
+        result = a;
+        for (std::size_t i = 0; i < N; i++)
+        {
+            result.set(i, i);
+        }
+        BitMatrix<N, N> square{};
+        for (std::size_t paths = 1; paths < N; paths *= 2)
+        {
+            multiply(square, result, result, policy);
+            if (square == result)
+                break;
+            std::swap(square, result);
+        }
+    }
+}
@@ -0,0 +1,206 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <cstddef>
+#include <limits>
+#include <algorithm>
+#include <matrix_operations/matrix_impl_2.h>
+
+namespace matrix_tiled
+{
+    /* Block sparse variant of the tiled matrix. Only non-zero tiles are stored. */
+    /* An occupancy index maps each (row block, column block) to its tile, */
+    /* so banded and block diagonal operands skip the empty tile products. */
+    template <typename T, std::size_t Rows, std::size_t Columns>
+    class BlockSparseMatrixImpl
+    {
+    public:
+        using Dense = MatrixImpl<T, Rows, Columns>;
+        static constexpr std::size_t BlockSize{Dense::BlockSize};
+        using Block = typename Dense::Block;
+        /* Index of a tile in blocks_, npos for an empty (all zero) tile */
+        static constexpr std::size_t npos{std::numeric_limits<std::size_t>::max()};
+        using Index = std::array<std::array<std::size_t, Columns / BlockSize>, Rows / BlockSize>;
+        /* Occupied column blocks of each row block (ascending) */
+        using Occupancy = std::array<std::vector<std::size_t>, Rows / BlockSize>;
+
+        BlockSparseMatrixImpl();
+        /* conversion from the dense tiled matrix, all zero tiles are dropped */
+        explicit BlockSparseMatrixImpl(const Dense &dense);
+
+        /* Public getters */
+        static constexpr std::size_t rows() noexcept { return Rows; }
+        static constexpr std::size_t columns() noexcept { return Columns; }
+        static constexpr std::size_t row_blocks() noexcept { return Rows / BlockSize; }
+        static constexpr std::size_t column_blocks() noexcept { return Columns / BlockSize; }
+
+        [[nodiscard]] std::size_t non_zero_blocks() const noexcept { return blocks_.size(); }
+        [[nodiscard]] bool has_block(std::size_t row_block, std::size_t column_block) const noexcept { return index_[row_block][column_block] != npos; }
+        [[nodiscard]] const Occupancy &occupancy() const noexcept { return occupancy_; }
+
+        /* nullptr if the tile is empty */
+        [[nodiscard]] const Block *block(std::size_t row_block, std::size_t column_block) const noexcept;
+        /* Allocate a zero tile if it is empty */
+        [[nodiscard]] Block &block_or_insert(std::size_t row_block, std::size_t column_block);
+
+        [[nodiscard]] Dense to_dense() const;
+
+        template <std::size_t OtherColumns>
+        [[nodiscard]] BlockSparseMatrixImpl<T, Rows, OtherColumns> operator*(const BlockSparseMatrixImpl<T, Columns, OtherColumns> &other) const;
+
+        /* Tiled multiplication that skips every tile pair where either side is empty */
+        template <std::size_t OtherColumns>
+        [[nodiscard]] BlockSparseMatrixImpl<T, Rows, OtherColumns> multiplication_tiled(const BlockSparseMatrixImpl<T, Columns, OtherColumns> &other) const;
+
+        /* Sparse * dense, only the occupied tiles of this matrix are visited */
+        template <std::size_t OtherColumns>
+        [[nodiscard]] MatrixImpl<T, Rows, OtherColumns> multiplication_tiled(const MatrixImpl<T, Columns, OtherColumns> &other) const noexcept;
+
+        [[nodiscard]] bool operator==(const BlockSparseMatrixImpl &other) const { return to_dense() == other.to_dense(); }
+
+    private:
+        static bool is_zero(const Block &block) noexcept;
+
+        Index index_{};
+        Occupancy occupancy_{};
+        std::vector<Block> blocks_{};
+    };
+
+    template <typename T, std::size_t Rows, std::size_t Columns>
+    BlockSparseMatrixImpl<T, Rows, Columns>::BlockSparseMatrixImpl()
+    {
+        static_assert(Rows % BlockSize == 0);
+        static_assert(Columns % BlockSize == 0);
+
+        for (auto &index_row : index_)
+        {
+            index_row.fill(npos);
+        }
+    }
+
+    template <typename T, std::size_t Rows, std::size_t Columns>
+    BlockSparseMatrixImpl<T, Rows, Columns>::BlockSparseMatrixImpl(const Dense &dense) : BlockSparseMatrixImpl()
+    {
+        for (std::size_t i{0}; i < row_blocks(); i++)
+        {
+            for (std::size_t j{0}; j < column_blocks(); j++)
+            {
+                const auto &tile = dense.data()[i][j];
+                if (!is_zero(tile))
+                {
+                    index_[i][j] = blocks_.size();
+                    occupancy_[i].push_back(j);
+                    blocks_.push_back(tile);
+                }
+            }
+        }
+    }
+
+    template <typename T, std::size_t Rows, std::size_t Columns>
+    bool BlockSparseMatrixImpl<T, Rows, Columns>::is_zero(const Block &block) noexcept
+    {
+        for (const auto &block_row : block)
+        {
+            for (const auto &value : block_row)
+            {
+                if (value != T{})
+                    return false;
+            }
+        }
+        return true;
+    }
+
+    template <typename T, std::size_t Rows, std::size_t Columns>
+    const typename BlockSparseMatrixImpl<T, Rows, Columns>::Block *BlockSparseMatrixImpl<T, Rows, Columns>::block(std::size_t row_block, std::size_t column_block) const noexcept
+    {
+        auto idx = index_[row_block][column_block];
+        return idx == npos ? nullptr : &blocks_[idx];
+    }
+
+    template <typename T, std::size_t Rows, std::size_t Columns>
+    typename BlockSparseMatrixImpl<T, Rows, Columns>::Block &BlockSparseMatrixImpl<T, Rows, Columns>::block_or_insert(std::size_t row_block, std::size_t column_block)
+    {
+        auto &idx = index_[row_block][column_block];
+        if (idx == npos)
+        {
+            idx = blocks_.size();
+            blocks_.emplace_back();
+            /* keep the occupancy list sorted so traversal stays row major */
+            auto &row = occupancy_[row_block];
+            row.insert(std::lower_bound(row.begin(), row.end(), column_block), column_block);
+        }
+        return blocks_[idx];
+    }
+
+    template <typename T, std::size_t Rows, std::size_t Columns>
+    typename BlockSparseMatrixImpl<T, Rows, Columns>::Dense BlockSparseMatrixImpl<T, Rows, Columns>::to_dense() const
+    {
+        Dense dense{};
+        for (std::size_t i{0}; i < row_blocks(); i++)
+        {
+            for (auto j : occupancy_[i])
+            {
+                dense.data()[i][j] = blocks_[index_[i][j]];
+            }
+        }
+        return dense;
+    }
+
+    template <typename T, std::size_t Rows, std::size_t Columns>
+    template <std::size_t OtherColumns>
+    BlockSparseMatrixImpl<T, Rows, OtherColumns> BlockSparseMatrixImpl<T, Rows, Columns>::operator*(const BlockSparseMatrixImpl<T, Columns, OtherColumns> &other) const
+    {
+        return multiplication_tiled(other);
+    }
+
+    template <typename T, std::size_t Rows, std::size_t Columns>
+    template <std::size_t OtherColumns>
+    BlockSparseMatrixImpl<T, Rows, OtherColumns> BlockSparseMatrixImpl<T, Rows, Columns>::multiplication_tiled(const BlockSparseMatrixImpl<T, Columns, OtherColumns> &other) const
+    {
+        BlockSparseMatrixImpl<T, Rows, OtherColumns> result{};
+
+        /* For each row block in A */
+        for (std::size_t i{0}; i < row_blocks(); i++)
+        {
+            /* For each non-empty column block in A (row block in B) */
+            for (auto j : occupancy_[i])
+            {
+                const auto &a = blocks_[index_[i][j]];
+                /* For each non-empty column block in B (column block in R) */
+                for (auto k : other.occupancy()[j])
+                {
+                    // r[i][k] = a[i, j] * b[j][k]
+                    auto &r = result.block_or_insert(i, k);
+                    Dense::multiplication_tiled_aux(a, *other.block(j, k), r);
+                }
+            }
+        }
+
+        return result;
+    }
+
+    template <typename T, std::size_t Rows, std::size_t Columns>
+    template <std::size_t OtherColumns>
+    MatrixImpl<T, Rows, OtherColumns> BlockSparseMatrixImpl<T, Rows, Columns>::multiplication_tiled(const MatrixImpl<T, Columns, OtherColumns> &other) const noexcept
+    {
+        MatrixImpl<T, Rows, OtherColumns> result{};
+
+        for (std::size_t i{0}; i < row_blocks(); i++)
+        {
+            for (auto j : occupancy_[i])
+            {
+                const auto &a = blocks_[index_[i][j]];
+                for (std::size_t k{0}; k < other.column_blocks(); k++)
+                {
+                    Dense::multiplication_tiled_aux(a, other.data()[j][k], result.data()[i][k]);
+                }
+            }
+        }
+
+        return result;
+    }
+
+    template <std::size_t Rows, std::size_t Columns>
+    using BlockSparseMatrix = BlockSparseMatrixImpl<double, Rows, Columns>;
+}
@@ -0,0 +1,306 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <optional>
+#include <vector>
+#include <matrix_operations/matrix.h>
+#include <matrix_operations/gemm.h>
+#include <matrix_operations/task_graph.h>
+
+/* Cholesky factorisation A = L . L^T of a symmetric positive definite matrix (LAPACK potrf) */
+/* and triangular solves with multiple right hand sides (trsm / potrs). */
+/* The matrix is split into tiles of cholesky_block_size. Step k factorises tile (k, k), */
+/* solves the tiles below it (TRSM) and updates the trailing tiles with SYRK (diagonal) and */
+/* GEMM (below the diagonal), which is where nearly all of the n^3 / 3 flops are. */
+/* On the pool backend the tile operations are nodes of a TaskGraph, a tile operation starts */
+/* as soon as the tiles it reads are final, so steps overlap. Other backends run the tiles */
+/* of each step with execution::run. */
+/* Only the lower triangle of A is read and overwritten with L, the upper one is not touched. */
+namespace matrix
+{
+    inline constexpr std::size_t cholesky_block_size{64};
+
+    /* op(L) of a triangular solve */
+    enum class Transpose
+    {
+        no,
+        yes,
+    };
+
+    namespace detail
+    {
+        template <typename T>
+        constexpr T dot(const T *x, const T *y, std::size_t n) noexcept
+        {
+            T sum{0};
+            for (std::size_t p = 0; p < n; p++)
+            {
+                sum += x[p] * y[p];
+            }
+            return sum;
+        }
+
+        /* unblocked Cholesky of an nb x nb tile, false if it is not positive definite */
+        template <typename T>
+        inline bool potrf_tile(T *a, std::size_t nb, std::size_t lda) noexcept
+        {
+            for (std::size_t j = 0; j < nb; j++)
+            {
+                auto *l_j = a + j * lda;
+                const auto d = l_j[j] - dot(l_j, l_j, j);
+                if (!(d > T{0}))
+                    return false;
+                l_j[j] = std::sqrt(d);
+                for (std::size_t i{j + 1}; i < nb; i++)
+                {
+                    auto *l_i = a + i * lda;
+                    l_i[j] = (l_i[j] - dot(l_i, l_j, j)) / l_j[j];
+                }
+            }
+            return true;
+        }
+
+        /* X = B . L^-T for a rows x nb tile B below the diagonal tile L */
+        template <typename T>
+        inline void trsm_tile(T *b, std::size_t rows, std::size_t ldb, const T *l, std::size_t nb, std::size_t ldl) noexcept
+        {
+            for (std::size_t r = 0; r < rows; r++)
+            {
+                auto *x = b + r * ldb;
+                for (std::size_t j = 0; j < nb; j++)
+                {
+                    x[j] = (x[j] - dot(x, l + j * ldl, j)) / l[j * ldl + j];
+                }
+            }
+        }
+
+        /* lower triangle of C -= A . A^T */
+        template <typename T>
+        inline void syrk_tile(T *c, std::size_t nb, std::size_t ldc, const T *a, std::size_t k, std::size_t lda) noexcept
+        {
+            for (std::size_t r = 0; r < nb; r++)
+            {
+                gemm_nt_aux(c, ldc, a, lda, a, lda, r + 1, k, T{-1}, r, r + 1);
+            }
+        }
+    }
+
+    /* Factorise the n x n matrix a in place, false if A is not positive definite */
+    template <typename T>
+    [[nodiscard]] inline bool potrf(T *a, std::size_t n, std::size_t lda, const execution::Policy &policy = execution::automatic)
+    {
+        const auto nb = cholesky_block_size;
+        const auto tiles = (n + nb - 1) / nb;
+        auto tile = [a, lda, nb](std::size_t i, std::size_t j)
+        { return a + i * nb * lda + j * nb; };
+        auto size = [n, nb](std::size_t i)
+        { return std::min(nb, n - i * nb); };
+
+        auto potrf_step = [&](std::size_t k)
+        { return detail::potrf_tile(tile(k, k), size(k), lda); };
+        auto trsm_step = [&](std::size_t i, std::size_t k)
+        { detail::trsm_tile(tile(i, k), size(i), lda, tile(k, k), size(k), lda); };
+        /* tile (i, j) -= L(i, k) . L(j, k)^T */
+        auto update_step = [&](std::size_t i, std::size_t j, std::size_t k)
+        {
+            if (i == j)
+                detail::syrk_tile(tile(i, i), size(i), lda, tile(i, k), size(k), lda);
+            else
+                gemm_nt_aux(tile(i, j), lda, tile(i, k), lda, tile(j, k), lda, size(j), size(k), T{-1}, 0, size(i));
+        };
+
+        if (execution::resolve(policy) == execution::Backend::pool && !execution::nested() && tiles > 1)
+        {
+            std::atomic<bool> positive_definite{true};
+            thread_pool::TaskGraph graph{};
+            /* last node writing each tile, later operations on the tile depend on it */
+            std::vector<std::optional<thread_pool::TaskGraph::NodeId>> last(tiles * tiles);
+            auto dependencies = [&last, tiles](std::initializer_list<std::pair<std::size_t, std::size_t>> used)
+            {
+                thread_pool::TaskGraph::Dependencies nodes{};
+                for (const auto &[i, j] : used)
+                {
+                    if (last[i * tiles + j])
+                        nodes.push_back(*last[i * tiles + j]);
+                }
+                return nodes;
+            };
+
+            for (std::size_t k = 0; k < tiles; k++)
+            {
+                last[k * tiles + k] = graph.add([&, k]()
+                                                { if (!potrf_step(k)) positive_definite = false; },
+                                                dependencies({{k, k}}));
+                for (std::size_t i{k + 1}; i < tiles; i++)
+                {
+                    last[i * tiles + k] = graph.add([&, i, k]()
+                                                    { trsm_step(i, k); },
+                                                    dependencies({{k, k}, {i, k}}));
+                }
+                for (std::size_t i{k + 1}; i < tiles; i++)
+                {
+                    for (std::size_t j{k + 1}; j <= i; j++)
+                    {
+                        last[i * tiles + j] = graph.add([&, i, j, k]()
+                                                        { update_step(i, j, k); },
+                                                        dependencies({{i, k}, {j, k}, {i, j}}));
+                    }
+                }
+            }
+            graph.run(execution::shared_pool());
+            return positive_definite;
+        }
+
+        std::vector<std::pair<std::size_t, std::size_t>> chunks{};
+        std::vector<std::pair<std::size_t, std::size_t>> updates{};
+        for (std::size_t k = 0; k < tiles; k++)
+        {
+            if (!potrf_step(k))
+                return false;
+
+            chunks.clear();
+            for (std::size_t i{k + 1}; i < tiles; i++)
+            {
+                chunks.emplace_back(i, i + 1);
+            }
+            execution::run(policy, chunks, [&](std::size_t start, std::size_t end)
+                           {
+                for (auto i = start; i < end; i++)
+                {
+                    trsm_step(i, k);
+                } });
+
+            chunks.clear();
+            updates.clear();
+            for (std::size_t i{k + 1}; i < tiles; i++)
+            {
+                for (std::size_t j{k + 1}; j <= i; j++)
+                {
+                    chunks.emplace_back(updates.size(), updates.size() + 1);
+                    updates.emplace_back(i, j);
+                }
+            }
+            execution::run(policy, chunks, [&](std::size_t start, std::size_t end)
+                           {
+                for (auto u = start; u < end; u++)
+                {
+                    update_step(updates[u].first, updates[u].second, k);
+                } });
+        }
+        return true;
+    }
+
+    /* Solve op(L) . X = B for the lower triangular n x n L, B (n x nrhs) is overwritten with X. */
+    /* Blocked: after the diagonal block of a block row is solved, its contribution to the */
+    /* remaining rows is removed with one GEMM. The right hand sides are split over the policy. */
+    template <typename T>
+    inline void trsm(const T *l, std::size_t n, std::size_t ldl, T *b, std::size_t nrhs, std::size_t ldb, Transpose transpose = Transpose::no, const execution::Policy &policy = execution::automatic)
+    {
+        const auto nb = cholesky_block_size;
+        execution::run(policy, even_chunks(nrhs, n * n * nrhs < 32 * 32 * 32 ? 1 : 8), [=](std::size_t start, std::size_t end)
+                       {
+            auto *b_chunk = b + start;
+            const auto width = end - start;
+            auto row = [b_chunk, ldb](std::size_t i)
+            { return b_chunk + i * ldb; };
+
+            if (transpose == Transpose::no)
+            {
+                /* forward substitution */
+                for (std::size_t k0 = 0; k0 < n; k0 += nb)
+                {
+                    const auto k1 = std::min(n, k0 + nb);
+                    for (std::size_t i{k0}; i < k1; i++)
+                    {
+                        auto *b_i = row(i);
+                        for (std::size_t p{k0}; p < i; p++)
+                        {
+                            const auto l_ip = l[i * ldl + p];
+                            const auto *b_p = row(p);
+                            for (std::size_t c = 0; c < width; c++)
+                            {
+                                b_i[c] -= l_ip * b_p[c];
+                            }
+                        }
+                        const auto l_ii = l[i * ldl + i];
+                        for (std::size_t c = 0; c < width; c++)
+                        {
+                            b_i[c] /= l_ii;
+                        }
+                    }
+                    /* B[k1..n) -= L[k1..n, k0..k1) . X[k0..k1) */
+                    gemm_aux(row(k1), ldb, l + k1 * ldl + k0, ldl, row(k0), ldb, width, k1 - k0, T{-1}, 0, n - k1);
+                }
+                return;
+            }
+
+            /* backward substitution with L^T, row i of L^T is column i of L */
+            for (std::size_t k1 = n; k1 > 0;)
+            {
+                const auto k0 = k1 > nb ? k1 - nb : 0;
+                for (std::size_t i = k1; i-- > k0;)
+                {
+                    auto *b_i = row(i);
+                    for (std::size_t p{i + 1}; p < k1; p++)
+                    {
+                        const auto l_pi = l[p * ldl + i];
+                        const auto *b_p = row(p);
+                        for (std::size_t c = 0; c < width; c++)
+                        {
+                            b_i[c] -= l_pi * b_p[c];
+                        }
+                    }
+                    const auto l_ii = l[i * ldl + i];
+                    for (std::size_t c = 0; c < width; c++)
+                    {
+                        b_i[c] /= l_ii;
+                    }
+                }
+                /* B[0..k0) -= L[k0..k1, 0..k0)^T . X[k0..k1), row p of L is streamed once */
+                for (std::size_t p{k0}; p < k1; p++)
+                {
+                    const auto *l_p = l + p * ldl;
+                    const auto *b_p = row(p);
+                    for (std::size_t i = 0; i < k0; i++)
+                    {
+                        auto *b_i = row(i);
+                        const auto l_pi = l_p[i];
+                        for (std::size_t c = 0; c < width; c++)
+                        {
+                            b_i[c] -= l_pi * b_p[c];
+                        }
+                    }
+                }
+                k1 = k0;
+            } });
+    }
+
+    /* Solve A . X = B with the factor L of potrf, B is overwritten with X */
+    template <typename T>
+    inline void potrs(const T *l, std::size_t n, std::size_t ldl, T *b, std::size_t nrhs, std::size_t ldb, const execution::Policy &policy = execution::automatic)
+    {
+        trsm(l, n, ldl, b, nrhs, ldb, Transpose::no, policy);
+        trsm(l, n, ldl, b, nrhs, ldb, Transpose::yes, policy);
+    }
+
+    template <typename T, std::size_t N>
+    [[nodiscard]] inline bool potrf(MatrixImpl<T, N, N> &a, const execution::Policy &policy = execution::automatic)
+    {
+        return potrf(a.data()[0].data(), N, N, policy);
+    }
+
+    template <typename T, std::size_t N, std::size_t Columns>
+    inline void trsm(const MatrixImpl<T, N, N> &l, MatrixImpl<T, N, Columns> &b, Transpose transpose = Transpose::no, const execution::Policy &policy = execution::automatic)
+    {
+        trsm(l.data()[0].data(), N, N, b.data()[0].data(), Columns, Columns, transpose, policy);
+    }
+
+    template <typename T, std::size_t N, std::size_t Columns>
+    inline void potrs(const MatrixImpl<T, N, N> &l, MatrixImpl<T, N, Columns> &b, const execution::Policy &policy = execution::automatic)
+    {
+        potrs(l.data()[0].data(), N, N, b.data()[0].data(), Columns, Columns, policy);
+    }
+}
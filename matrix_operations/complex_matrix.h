@@ -0,0 +1,195 @@
+#pragma once
+
+#include <complex>
+#include <cstddef>
+#include <new>
+#include <matrix_operations/matrix.h>
+#include <matrix_operations/packed_matrix.h>
+#include <matrix_operations/allocator.h>
+
+/* Complex matrices in split storage, the real parts and the imaginary parts are two real */
+/* matrices (planes). A complex product then becomes real products of the planes on the */
+/* packed panel kernel (packed_matrix.h) instead of scalar std::complex arithmetic: */
+/* 4M: Re = Ar . Br - Ai . Bi and Im = Ar . Bi + Ai . Br, four real products. */
+/* 3M (Gauss): T1 = Ar . Br, T2 = Ai . Bi, Re = T1 - T2 and Im = (Ar + Ai) . (Br + Bi) - T1 - T2, */
+/* three real products. Im is a difference of larger terms, its rounding error is relative */
+/* to |A| |B| rather than to |Im|; use 4M when that matters. */
+/* The planes of B are packed once per product, the chunks of rows run on the policy's */
+/* backend and combine their products while the rows are in cache. */
+namespace matrix
+{
+    enum class ComplexMethod
+    {
+        four_m,
+        three_m,
+    };
+
+    namespace detail
+    {
+        template <typename M>
+        inline memory::MatrixPtr<M> allocate_plane()
+        {
+            auto m = memory::make_matrix<M>();
+            if (!m)
+                throw std::bad_alloc{};
+            return m;
+        }
+    }
+
+    template <typename T, std::size_t Rows, std::size_t Columns>
+    class SplitComplexMatrix
+    {
+    public:
+        using Plane = MatrixImpl<T, Rows, Columns>;
+
+        /* zero */
+        SplitComplexMatrix() : real_{detail::allocate_plane<Plane>()}, imag_{detail::allocate_plane<Plane>()} {}
+        explicit SplitComplexMatrix(const MatrixImpl<std::complex<T>, Rows, Columns> &m) : SplitComplexMatrix()
+        {
+            for (std::size_t i = 0; i < Rows; i++)
+            {
+                for (std::size_t j = 0; j < Columns; j++)
+                {
+                    real_->data()[i][j] = m.data()[i][j].real();
+                    imag_->data()[i][j] = m.data()[i][j].imag();
+                }
+            }
+        }
+
+        static constexpr std::size_t rows() noexcept { return Rows; }
+        static constexpr std::size_t columns() noexcept { return Columns; }
+
+        [[nodiscard]] Plane &real() noexcept { return *real_; }
+        [[nodiscard]] const Plane &real() const noexcept { return *real_; }
+        [[nodiscard]] Plane &imag() noexcept { return *imag_; }
+        [[nodiscard]] const Plane &imag() const noexcept { return *imag_; }
+
+        [[nodiscard]] std::complex<T> operator()(std::size_t i, std::size_t j) const noexcept
+        {
+            return {real_->data()[i][j], imag_->data()[i][j]};
+        }
+
+        void to_matrix(MatrixImpl<std::complex<T>, Rows, Columns> &result) const noexcept
+        {
+            for (std::size_t i = 0; i < Rows; i++)
+            {
+                for (std::size_t j = 0; j < Columns; j++)
+                {
+                    result.data()[i][j] = (*this)(i, j);
+                }
+            }
+        }
+
+    private:
+        memory::MatrixPtr<Plane> real_;
+        memory::MatrixPtr<Plane> imag_;
+    };
+
+    /* Buffers of a complex product, reused between calls so repeated products don't allocate */
+    template <typename T, std::size_t Rows, std::size_t Columns, std::size_t OtherColumns>
+    class ComplexWorkspace
+    {
+    public:
+        ComplexWorkspace()
+            : a_sum_{detail::allocate_plane<MatrixImpl<T, Rows, Columns>>()},
+              b_sum_{detail::allocate_plane<MatrixImpl<T, Columns, OtherColumns>>()},
+              product_{detail::allocate_plane<MatrixImpl<T, Rows, OtherColumns>>()}
+        {
+        }
+
+        /* Br, Bi and (3M) Br + Bi */
+        [[nodiscard]] PackedMatrix<T, Columns, OtherColumns> &packed(std::size_t i) noexcept { return packed_[i]; }
+        /* Ar + Ai and Br + Bi (3M) */
+        [[nodiscard]] MatrixImpl<T, Rows, Columns> &a_sum() noexcept { return *a_sum_; }
+        [[nodiscard]] MatrixImpl<T, Columns, OtherColumns> &b_sum() noexcept { return *b_sum_; }
+        /* the product that is not written into R directly */
+        [[nodiscard]] MatrixImpl<T, Rows, OtherColumns> &product() noexcept { return *product_; }
+
+    private:
+        PackedMatrix<T, Columns, OtherColumns> packed_[3]{};
+        memory::MatrixPtr<MatrixImpl<T, Rows, Columns>> a_sum_;
+        memory::MatrixPtr<MatrixImpl<T, Columns, OtherColumns>> b_sum_;
+        memory::MatrixPtr<MatrixImpl<T, Rows, OtherColumns>> product_;
+    };
+
+    /* R = A . B, R must not be A or B */
+    template <typename T, std::size_t Rows, std::size_t Columns, std::size_t OtherColumns>
+    inline void multiply(SplitComplexMatrix<T, Rows, OtherColumns> &result, const SplitComplexMatrix<T, Rows, Columns> &a, const SplitComplexMatrix<T, Columns, OtherColumns> &b, ComplexWorkspace<T, Rows, Columns, OtherColumns> &workspace, ComplexMethod method = ComplexMethod::three_m, const execution::Policy &policy = execution::automatic)
+    {
+        auto &b_re = workspace.packed(0);
+        auto &b_im = workspace.packed(1);
+        auto &b_sum = workspace.packed(2);
+        b_re.pack(b.real(), Packing::panels);
+        b_im.pack(b.imag(), Packing::panels);
+        auto &r_re = result.real();
+        auto &r_im = result.imag();
+        auto &product = workspace.product();
+
+        if (method == ComplexMethod::four_m)
+        {
+            execution::run(policy, MatrixImpl<T, Rows, Columns>::get_chunks(), [&](std::size_t start, std::size_t end)
+                           {
+                packed_multiplication_aux(r_re, a.real(), b_re, start, end);
+                packed_multiplication_aux(product, a.imag(), b_im, start, end);
+                for (std::size_t i{start}; i < end; i++)
+                {
+                    for (std::size_t j = 0; j < OtherColumns; j++)
+                    {
+                        r_re.data()[i][j] -= product.data()[i][j];
+                    }
+                }
+                packed_multiplication_aux(r_im, a.real(), b_im, start, end);
+                packed_multiplication_aux(product, a.imag(), b_re, start, end);
+                for (std::size_t i{start}; i < end; i++)
+                {
+                    for (std::size_t j = 0; j < OtherColumns; j++)
+                    {
+                        r_im.data()[i][j] += product.data()[i][j];
+                    }
+                } });
+            return;
+        }
+
+        /* Br + Bi, packed like the planes */
+        auto &b_plane_sum = workspace.b_sum();
+        for (std::size_t k = 0; k < Columns; k++)
+        {
+            for (std::size_t j = 0; j < OtherColumns; j++)
+            {
+                b_plane_sum.data()[k][j] = b.real().data()[k][j] + b.imag().data()[k][j];
+            }
+        }
+        b_sum.pack(b_plane_sum, Packing::panels);
+        execution::run(policy, MatrixImpl<T, Rows, Columns>::get_chunks(), [&](std::size_t start, std::size_t end)
+                       {
+            auto &a_sum = workspace.a_sum();
+            for (std::size_t i{start}; i < end; i++)
+            {
+                for (std::size_t k = 0; k < Columns; k++)
+                {
+                    a_sum.data()[i][k] = a.real().data()[i][k] + a.imag().data()[i][k];
+                }
+            }
+            /* T1 in Re, T2 in Im and T3 in the product */
+            packed_multiplication_aux(r_re, a.real(), b_re, start, end);
+            packed_multiplication_aux(r_im, a.imag(), b_im, start, end);
+            packed_multiplication_aux(product, a_sum, b_sum, start, end);
+            for (std::size_t i{start}; i < end; i++)
+            {
+                for (std::size_t j = 0; j < OtherColumns; j++)
+                {
+                    const auto t1 = r_re.data()[i][j];
+                    const auto t2 = r_im.data()[i][j];
+                    r_re.data()[i][j] = t1 - t2;
+                    r_im.data()[i][j] = product.data()[i][j] - t1 - t2;
+                }
+            } });
+    }
+
+    template <typename T, std::size_t Rows, std::size_t Columns, std::size_t OtherColumns>
+    inline void multiply(SplitComplexMatrix<T, Rows, OtherColumns> &result, const SplitComplexMatrix<T, Rows, Columns> &a, const SplitComplexMatrix<T, Columns, OtherColumns> &b, ComplexMethod method = ComplexMethod::three_m, const execution::Policy &policy = execution::automatic)
+    {
+        ComplexWorkspace<T, Rows, Columns, OtherColumns> workspace{};
+        multiply(result, a, b, workspace, method, policy);
+    }
+}
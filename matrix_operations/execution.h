@@ -0,0 +1,304 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <vector>
+#include <omp.h>
+#include <matrix_operations/thread_pool.h>
+
+/* Execution policies for the chunked kernels. */
+/* A kernel is written once as func(start, end) over row chunks and the policy decides */
+/* which threads run the chunks. Backend::automatic resolves to the process wide default, */
+/* so by default every operation uses the same thread team instead of each backend */
+/* starting its own threads on top of the others. */
+/* Calls made from inside a parallel region (a chunk, a pool worker or an OpenMP team) run */
+/* serially, and the threads / omp backends only start the extra threads the global budget allows. */
+namespace execution
+{
+    enum class Backend
+    {
+        /* the process wide default, see set_default_backend */
+        automatic,
+        /* the calling thread */
+        serial,
+        /* std::threads created for every call, one per chunk as far as the thread budget allows */
+        threads,
+        /* the shared thread pool, the caller takes part (fork/join) */
+        pool,
+        /* an OpenMP parallel for over the chunks */
+        omp,
+    };
+
+    struct Policy
+    {
+        Backend backend{Backend::automatic};
+        /* pool backend only */
+        thread_pool::ForkJoin mode{thread_pool::ForkJoin::caller_participates};
+        thread_pool::Priority priority{thread_pool::Priority::normal};
+    };
+
+    /* How a cancellable operation ended */
+    enum class Status
+    {
+        complete,
+        cancelled,
+        deadline_exceeded,
+    };
+
+    /* Stop token and deadline of a cancellable operation, checked before every block of rows */
+    struct Cancellation
+    {
+        using Clock = std::chrono::steady_clock;
+
+        std::stop_token token{};
+        Clock::time_point deadline{Clock::time_point::max()};
+        /* rows per block, abandoned work frees the threads within one block */
+        std::size_t block_rows{16};
+
+        [[nodiscard]] Status check() const noexcept
+        {
+            if (token.stop_requested())
+                return Status::cancelled;
+            if (deadline != Clock::time_point::max() && Clock::now() >= deadline)
+                return Status::deadline_exceeded;
+            return Status::complete;
+        }
+    };
+
+    inline Cancellation with_timeout(Cancellation::Clock::duration timeout, std::stop_token token = {})
+    {
+        return Cancellation{std::move(token), Cancellation::Clock::now() + timeout};
+    }
+
+    /* Result of a cancellable operation. The output is only valid if ok(), */
+    /* otherwise completed of total row blocks were computed. */
+    struct Outcome
+    {
+        Status status{Status::complete};
+        std::size_t completed{0};
+        std::size_t total{0};
+
+        [[nodiscard]] bool ok() const noexcept { return status == Status::complete; }
+    };
+
+    inline constexpr Policy automatic{};
+    inline constexpr Policy serial{Backend::serial};
+    inline constexpr Policy threads{Backend::threads};
+    inline constexpr Policy pool{Backend::pool};
+    inline constexpr Policy omp{Backend::omp};
+
+    namespace detail
+    {
+        inline std::atomic<Backend> default_backend{Backend::pool};
+
+        /* chunks of a parallel operation being run by this thread */
+        inline thread_local std::size_t parallel_depth{0};
+
+        inline std::size_t hardware_threads() noexcept
+        {
+            return std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+        }
+
+        /* extra threads (beyond the callers) that may run at once, across all callers */
+        inline std::mutex budget_mtx{};
+        inline std::size_t budget_limit{hardware_threads()};
+        inline std::ptrdiff_t budget_available{static_cast<std::ptrdiff_t>(hardware_threads())};
+
+        /* Marks the calling thread as inside a parallel region */
+        struct ParallelRegion
+        {
+            ParallelRegion() noexcept { parallel_depth++; }
+            ParallelRegion(const ParallelRegion &) = delete;
+            ~ParallelRegion() { parallel_depth--; }
+        };
+    }
+
+    /* The calling thread already runs a chunk of a parallel operation, a pool task or an OpenMP team */
+    [[nodiscard]] inline bool nested() noexcept
+    {
+        return detail::parallel_depth > 0 || thread_pool::this_thread_is_worker() || omp_in_parallel();
+    }
+
+    /* Extra threads the threads / omp backends may start at the same time, process wide. */
+    /* Defaults to the number of hardware threads. Threads in use keep their share until released. */
+    inline void set_thread_budget(std::size_t threads)
+    {
+        std::lock_guard guard(detail::budget_mtx);
+        detail::budget_available += static_cast<std::ptrdiff_t>(threads) - static_cast<std::ptrdiff_t>(detail::budget_limit);
+        detail::budget_limit = threads;
+    }
+
+    [[nodiscard]] inline std::size_t thread_budget() noexcept
+    {
+        std::lock_guard guard(detail::budget_mtx);
+        return detail::budget_limit;
+    }
+
+    /* Threads of the shared pool and of an OpenMP team: one per hardware thread, capped by */
+    /* the thread budget */
+    [[nodiscard]] inline std::size_t default_threads() noexcept
+    {
+        return std::max<std::size_t>(std::min(detail::hardware_threads(), thread_budget()), 1);
+    }
+
+    /* Threads granted to one parallel operation, the caller included, returned on destruction. */
+    /* A nested call or an exhausted budget gets a team of 1, i.e. the operation runs serially. */
+    class Team
+    {
+    public:
+        explicit Team(std::size_t wanted)
+        {
+            if (wanted <= 1 || nested())
+                return;
+            std::lock_guard guard(detail::budget_mtx);
+            extra_ = static_cast<std::size_t>(std::clamp<std::ptrdiff_t>(detail::budget_available, 0, static_cast<std::ptrdiff_t>(wanted - 1)));
+            detail::budget_available -= static_cast<std::ptrdiff_t>(extra_);
+        }
+        Team(const Team &) = delete;
+        ~Team()
+        {
+            if (extra_ > 0)
+            {
+                std::lock_guard guard(detail::budget_mtx);
+                detail::budget_available += static_cast<std::ptrdiff_t>(extra_);
+            }
+        }
+
+        [[nodiscard]] std::size_t threads() const noexcept { return extra_ + 1; }
+
+    private:
+        std::size_t extra_{0};
+    };
+
+    /* Backend used by Backend::automatic. Set it once at start up, e.g. to omp when the */
+    /* rest of the process already uses OpenMP, and the shared pool is never started. */
+    inline void set_default_backend(Backend backend) noexcept
+    {
+        detail::default_backend.store(backend == Backend::automatic ? Backend::pool : backend, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] inline Backend default_backend() noexcept
+    {
+        return detail::default_backend.load(std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] inline Backend resolve(const Policy &policy) noexcept
+    {
+        return policy.backend == Backend::automatic ? default_backend() : policy.backend;
+    }
+
+    namespace detail
+    {
+        /* One worker per hardware thread, capped by the thread budget when the pool starts. */
+        /* Idle workers park (thread_pool::WorkerLockFree), a started pool costs no CPU. */
+        struct SharedPool
+        {
+            SharedPool() { pool.init(default_threads()); }
+            thread_pool::ThreadPool pool{};
+        };
+    }
+
+    /* The shared pool, started on first use. Set the thread budget before, to size it. */
+    inline thread_pool::ThreadPool &shared_pool()
+    {
+        static detail::SharedPool shared{};
+        return shared.pool;
+    }
+
+    /* Execute func(start, end) for each chunk with the policy's backend and block until all chunks are done. */
+    /* Nested calls run serially, the threads and omp backends shrink to the team the budget grants. */
+    template <typename Chunks, typename F>
+    inline void run(const Policy &policy, const Chunks &chunks, const F &func)
+    {
+        auto backend = resolve(policy);
+        if (backend != Backend::serial && (chunks.size() <= 1 || nested()))
+            backend = Backend::serial;
+
+        /* chunks run inside a parallel region, multiplies made from them are serial */
+        auto region = [&func](std::size_t start, std::size_t end)
+        {
+            detail::ParallelRegion guard{};
+            func(start, end);
+        };
+
+        switch (backend)
+        {
+        case Backend::threads:
+        {
+            /* the caller is part of the team, chunks are claimed dynamically */
+            Team team{chunks.size()};
+            std::atomic<std::size_t> next{0};
+            auto drain = [&chunks, &region, &next]()
+            {
+                for (std::size_t i{}; (i = next.fetch_add(1, std::memory_order_relaxed)) < chunks.size();)
+                {
+                    region(chunks[i].first, chunks[i].second);
+                }
+            };
+            std::vector<std::thread> workers{};
+            for (std::size_t i = 1; i < team.threads(); i++)
+            {
+                workers.emplace_back(drain);
+            }
+            drain();
+            for (auto &worker : workers)
+            {
+                worker.join();
+            }
+            break;
+        }
+        case Backend::pool:
+            thread_pool::fork_join(shared_pool(), chunks, region, policy.mode, policy.priority);
+            break;
+        case Backend::omp:
+        {
+            Team team{std::min(chunks.size(), default_threads())};
+            /* num_threads sets the team of this region only, the global OpenMP state is untouched */
+            const auto number_of_chunks = static_cast<std::ptrdiff_t>(chunks.size());
+#pragma omp parallel for num_threads(static_cast<int>(team.threads())) schedule(static)
+            for (std::ptrdiff_t i = 0; i < number_of_chunks; i++)
+            {
+                region(chunks[i].first, chunks[i].second);
+            }
+            break;
+        }
+        default:
+            for (const auto &[start, end] : chunks)
+            {
+                func(start, end);
+            }
+            break;
+        }
+    }
+
+    /* As run, but the chunks are split into blocks of cancellation.block_rows rows and the */
+    /* token and deadline are checked before each block. Once stopped the remaining blocks are skipped. */
+    template <typename Chunks, typename F>
+    [[nodiscard]] inline Outcome run(const Policy &policy, const Chunks &chunks, const F &func, const Cancellation &cancellation)
+    {
+        const auto blocks = thread_pool::split_chunks(chunks, cancellation.block_rows);
+        std::atomic<Status> status{cancellation.check()};
+        std::atomic<std::size_t> completed{0};
+        if (status == Status::complete)
+        {
+            run(policy, blocks, [&func, &cancellation, &status, &completed](std::size_t start, std::size_t end)
+                {
+                if (status.load(std::memory_order_relaxed) != Status::complete)
+                    return;
+                if (auto stopped = cancellation.check(); stopped != Status::complete)
+                {
+                    auto expected = Status::complete;
+                    status.compare_exchange_strong(expected, stopped, std::memory_order_relaxed);
+                    return;
+                }
+                func(start, end);
+                completed.fetch_add(1, std::memory_order_relaxed); });
+        }
+        return Outcome{status.load(), completed.load(), blocks.size()};
+    }
+}
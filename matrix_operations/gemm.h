@@ -0,0 +1,106 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include <matrix_operations/execution.h>
+
+/* GEMM on row major blocks addressed with a leading dimension (the distance between two rows). */
+/* Blocks of a MatrixImpl, of a flat buffer or of a scratch arena all have this form, so */
+/* blocked factorisations of any size use the same kernel as MatrixImpl::multiplication. */
+namespace matrix
+{
+    /* Rows split into number_of_chunks chunks of (almost) the same height */
+    inline std::vector<std::pair<std::size_t, std::size_t>> even_chunks(std::size_t length, std::size_t number_of_chunks)
+    {
+        std::vector<std::pair<std::size_t, std::size_t>> chunks{};
+        number_of_chunks = std::clamp<std::size_t>(number_of_chunks, 1, std::max<std::size_t>(length, 1));
+        std::size_t start{0};
+        for (std::size_t i = 0; i < number_of_chunks; i++)
+        {
+            auto chunk_length = length / number_of_chunks + (i < length % number_of_chunks ? 1 : 0);
+            chunks.emplace_back(start, start + chunk_length);
+            start += chunk_length;
+        }
+        return chunks;
+    }
+
+    /* C[start..end) += alpha . A[start..end) . B, A is m x k, B is k x n */
+    /* Same i-k-j order as MatrixImpl::multiplication_t_aux, B and C are traversed by rows */
+    template <typename T>
+    constexpr void gemm_aux(T *c, std::size_t ldc, const T *a, std::size_t lda, const T *b, std::size_t ldb, std::size_t n, std::size_t k, T alpha, std::size_t start, std::size_t end) noexcept
+    {
+        for (std::size_t i{start}; i < end; i++)
+        {
+            auto *c_i = c + i * ldc;
+            for (std::size_t p = 0; p < k; p++)
+            {
+                auto a_ip = alpha * a[i * lda + p];
+                const auto *b_p = b + p * ldb;
+                for (std::size_t j = 0; j < n; j++)
+                {
+                    c_i[j] += a_ip * b_p[j];
+                }
+            }
+        }
+    }
+
+    /* C[start..end) += alpha . A[start..end) . B^T, A is m x k, B is n x k */
+    /* Every element is a dot product of two contiguous rows, 4 of them share each load of A[i] */
+    template <typename T>
+    constexpr void gemm_nt_aux(T *c, std::size_t ldc, const T *a, std::size_t lda, const T *b, std::size_t ldb, std::size_t n, std::size_t k, T alpha, std::size_t start, std::size_t end) noexcept
+    {
+        for (std::size_t i{start}; i < end; i++)
+        {
+            const auto *a_i = a + i * lda;
+            auto *c_i = c + i * ldc;
+            std::size_t j{0};
+            for (; j + 4 <= n; j += 4)
+            {
+                const auto *b_0 = b + j * ldb;
+                const auto *b_1 = b_0 + ldb;
+                const auto *b_2 = b_1 + ldb;
+                const auto *b_3 = b_2 + ldb;
+                T sum0{0};
+                T sum1{0};
+                T sum2{0};
+                T sum3{0};
+                for (std::size_t p = 0; p < k; p++)
+                {
+                    auto a_ip = a_i[p];
+                    sum0 += a_ip * b_0[p];
+                    sum1 += a_ip * b_1[p];
+                    sum2 += a_ip * b_2[p];
+                    sum3 += a_ip * b_3[p];
+                }
+                c_i[j] += alpha * sum0;
+                c_i[j + 1] += alpha * sum1;
+                c_i[j + 2] += alpha * sum2;
+                c_i[j + 3] += alpha * sum3;
+            }
+            for (; j < n; j++)
+            {
+                const auto *b_j = b + j * ldb;
+                T sum{0};
+                for (std::size_t p = 0; p < k; p++)
+                {
+                    sum += a_i[p] * b_j[p];
+                }
+                c_i[j] += alpha * sum;
+            }
+        }
+    }
+
+    /* C += alpha . A . B, the rows of C are split over the policy's backend */
+    template <typename T>
+    inline void gemm(T *c, std::size_t ldc, const T *a, std::size_t lda, const T *b, std::size_t ldb, std::size_t m, std::size_t n, std::size_t k, T alpha = T{1}, const execution::Policy &policy = execution::automatic)
+    {
+        if (m == 0 || n == 0 || k == 0)
+            return;
+        /* small updates are not worth waking up the threads */
+        const auto number_of_chunks = m * n * k < 32 * 32 * 32 ? 1 : 8;
+        execution::run(policy, even_chunks(m, number_of_chunks), [=](std::size_t start, std::size_t end)
+                       { gemm_aux(c, ldc, a, lda, b, ldb, n, k, alpha, start, end); });
+    }
+}
@@ -0,0 +1,257 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <new>
+#include <vector>
+#include <matrix_operations/matrix.h>
+#include <matrix_operations/solution.h>
+#include <matrix_operations/allocator.h>
+
+/* R = A . B + C kept up to date while a few rows of A, rows / columns / elements of B */
+/* or elements of C change between updates. Changes are recorded when they are made and */
+/* update() only touches what they affect: */
+/*  - a changed row of A recomputes that row of R with ab_c_optimised_aux, O(n^2) */
+/*  - k changed rows of B are a rank k update R += A[:, K] . dB[K, :], O(k n^2) */
+/*  - a changed column of B updates one column of R, R[:, j] += A . dB[:, j], O(n^2) */
+/*  - a changed element of C is added to its element of R, O(1) */
+/* When the changes cost more than a full product, R is recomputed instead. */
+/* Rank updates accumulate rounding errors, recompute() resynchronises R. */
+namespace matrix
+{
+    template <typename T, std::size_t Rows, std::size_t Columns, std::size_t OtherColumns>
+    class IncrementalProduct
+    {
+    public:
+        using A = MatrixImpl<T, Rows, Columns>;
+        using B = MatrixImpl<T, Columns, OtherColumns>;
+        using C = MatrixImpl<T, Rows, OtherColumns>;
+
+        /* The operands are copied to the heap, R is computed with the policy's backend */
+        IncrementalProduct(const A &a, const B &b, const C &c, const execution::Policy &policy = execution::automatic)
+            : a_(allocate<A>()), b_(allocate<B>()), c_(allocate<C>()), r_(allocate<C>())
+        {
+            *a_ = a;
+            *b_ = b;
+            *c_ = c;
+            recompute(policy);
+        }
+
+        [[nodiscard]] const A &a() const noexcept { return *a_; }
+        [[nodiscard]] const B &b() const noexcept { return *b_; }
+        [[nodiscard]] const C &c() const noexcept { return *c_; }
+        /* A . B + C as of the last update() */
+        [[nodiscard]] const C &result() const noexcept { return *r_; }
+
+        /* Changes since the last update() */
+        [[nodiscard]] bool pending() const noexcept
+        {
+            return !a_rows_.empty() || !b_rows_.empty() || !b_columns_.empty() || !c_deltas_.empty();
+        }
+
+        void set_a(std::size_t i, std::size_t k, T value)
+        {
+            a_->data()[i][k] = value;
+            mark_a_row(i);
+        }
+        void set_a_row(std::size_t i, const std::array<T, Columns> &row)
+        {
+            a_->data()[i] = row;
+            mark_a_row(i);
+        }
+
+        void set_b(std::size_t k, std::size_t j, T value)
+        {
+            b_row_delta(k)[j] += value - b_->data()[k][j];
+            b_->data()[k][j] = value;
+        }
+        void set_b_row(std::size_t k, const std::array<T, OtherColumns> &row)
+        {
+            auto *delta = b_row_delta(k);
+            for (std::size_t j = 0; j < OtherColumns; j++)
+            {
+                delta[j] += row[j] - b_->data()[k][j];
+            }
+            b_->data()[k] = row;
+        }
+        void set_b_column(std::size_t j, const std::array<T, Columns> &column)
+        {
+            auto *delta = b_column_delta(j);
+            for (std::size_t k = 0; k < Columns; k++)
+            {
+                delta[k] += column[k] - b_->data()[k][j];
+                b_->data()[k][j] = column[k];
+            }
+        }
+
+        void set_c(std::size_t i, std::size_t j, T value)
+        {
+            c_deltas_.push_back({i, j, value - c_->data()[i][j]});
+            c_->data()[i][j] = value;
+        }
+
+        /* Bring R up to date with the recorded changes, rows are split over the policy's backend */
+        void update(const execution::Policy &policy = execution::automatic)
+        {
+            if (!pending())
+                return;
+            if (incremental_cost() >= Rows * Columns * OtherColumns)
+            {
+                recompute(policy);
+                return;
+            }
+
+            execution::run(policy, A::get_chunks(), [this](std::size_t start, std::size_t end)
+                           { update_aux(start, end); });
+            for (const auto &[i, j, delta] : c_deltas_)
+            {
+                /* dirty rows of A were recomputed with the new C */
+                if (!a_dirty_[i])
+                    r_->data()[i][j] += delta;
+            }
+            clear();
+        }
+
+        /* R = A . B + C from scratch */
+        void recompute(const execution::Policy &policy = execution::automatic)
+        {
+            *r_ = C{};
+            execution::run(policy, A::get_chunks(), [this](std::size_t start, std::size_t end)
+                           { ab_c_optimised_aux(*r_, *a_, *b_, *c_, start, end); });
+            clear();
+        }
+
+    private:
+        struct CDelta
+        {
+            std::size_t i;
+            std::size_t j;
+            T delta;
+        };
+
+        static constexpr std::size_t npos{static_cast<std::size_t>(-1)};
+
+        template <typename M>
+        static memory::MatrixPtr<M> allocate()
+        {
+            auto m = memory::make_matrix<M>();
+            if (!m)
+                throw std::bad_alloc{};
+            return m;
+        }
+
+        void mark_a_row(std::size_t i)
+        {
+            if (!a_dirty_[i])
+            {
+                a_dirty_[i] = true;
+                a_rows_.push_back(i);
+            }
+        }
+
+        /* accumulated change of row k of B */
+        T *b_row_delta(std::size_t k)
+        {
+            if (b_row_slot_[k] == npos)
+            {
+                b_row_slot_[k] = b_rows_.size();
+                b_rows_.push_back(k);
+                b_row_deltas_.resize(b_rows_.size() * OtherColumns, T{0});
+            }
+            return b_row_deltas_.data() + b_row_slot_[k] * OtherColumns;
+        }
+
+        /* accumulated change of column j of B, stored contiguously */
+        T *b_column_delta(std::size_t j)
+        {
+            if (b_column_slot_[j] == npos)
+            {
+                b_column_slot_[j] = b_columns_.size();
+                b_columns_.push_back(j);
+                b_column_deltas_.resize(b_columns_.size() * Columns, T{0});
+            }
+            return b_column_deltas_.data() + b_column_slot_[j] * Columns;
+        }
+
+        [[nodiscard]] std::size_t incremental_cost() const noexcept
+        {
+            const auto clean_rows = Rows - a_rows_.size();
+            return a_rows_.size() * Columns * OtherColumns + clean_rows * (b_rows_.size() * OtherColumns + b_columns_.size() * Columns) + c_deltas_.size();
+        }
+
+        void update_aux(std::size_t start, std::size_t end)
+        {
+            for (std::size_t i{start}; i < end; i++)
+            {
+                auto &r_i = r_->data()[i];
+                if (a_dirty_[i])
+                {
+                    r_i.fill(T{0});
+                    ab_c_optimised_aux(*r_, *a_, *b_, *c_, i, i + 1);
+                    continue;
+                }
+
+                const auto &a_i = a_->data()[i];
+                /* rank k update with the changed rows of B */
+                for (std::size_t s = 0; s < b_rows_.size(); s++)
+                {
+                    auto a_ik = a_i[b_rows_[s]];
+                    const auto *delta = b_row_deltas_.data() + s * OtherColumns;
+                    for (std::size_t j = 0; j < OtherColumns; j++)
+                    {
+                        r_i[j] += a_ik * delta[j];
+                    }
+                }
+                /* changed columns of B */
+                for (std::size_t s = 0; s < b_columns_.size(); s++)
+                {
+                    const auto *delta = b_column_deltas_.data() + s * Columns;
+                    T sum{0};
+                    for (std::size_t k = 0; k < Columns; k++)
+                    {
+                        sum += a_i[k] * delta[k];
+                    }
+                    r_i[b_columns_[s]] += sum;
+                }
+            }
+        }
+
+        void clear()
+        {
+            for (auto i : a_rows_)
+            {
+                a_dirty_[i] = false;
+            }
+            for (auto k : b_rows_)
+            {
+                b_row_slot_[k] = npos;
+            }
+            for (auto j : b_columns_)
+            {
+                b_column_slot_[j] = npos;
+            }
+            /* clear keeps the capacity, steady state ticks don't allocate */
+            a_rows_.clear();
+            b_rows_.clear();
+            b_row_deltas_.clear();
+            b_columns_.clear();
+            b_column_deltas_.clear();
+            c_deltas_.clear();
+        }
+
+        memory::MatrixPtr<A> a_;
+        memory::MatrixPtr<B> b_;
+        memory::MatrixPtr<C> c_;
+        memory::MatrixPtr<C> r_;
+
+        std::vector<bool> a_dirty_ = std::vector<bool>(Rows, false);
+        std::vector<std::size_t> a_rows_{};
+        std::vector<std::size_t> b_row_slot_ = std::vector<std::size_t>(Columns, npos);
+        std::vector<std::size_t> b_rows_{};
+        std::vector<T> b_row_deltas_{};
+        std::vector<std::size_t> b_column_slot_ = std::vector<std::size_t>(OtherColumns, npos);
+        std::vector<std::size_t> b_columns_{};
+        std::vector<T> b_column_deltas_{};
+        std::vector<CDelta> c_deltas_{};
+    };
+}
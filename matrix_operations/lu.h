@@ -0,0 +1,238 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <matrix_operations/matrix.h>
+#include <matrix_operations/gemm.h>
+#include <matrix_operations/scratch_arena.h>
+
+/* LU factorisation with partial pivoting, P . A = L . U (LAPACK getrf / getrs). */
+/* Right looking and blocked: a panel of lu_block_size columns is factorised, the block row */
+/* of U is solved with L11, and the trailing matrix A22 -= L21 . U12 is a GEMM (gemm.h) */
+/* split over the execution policy. For n >> lu_block_size nearly all flops are in the GEMM. */
+/* The matrices are row major with a leading dimension, MatrixImpl overloads are below. */
+/* L (unit diagonal, not stored) and U overwrite A, ipiv[i] is the row swapped with row i. */
+/* A pivot with |u_jj| <= n eps max|A| counts as zero: rounding leaves such a residue where */
+/* an exact zero is expected (e.g. two equal rows), and its inverse would be garbage. */
+namespace matrix
+{
+    inline constexpr std::size_t lu_block_size{64};
+
+    namespace detail
+    {
+        /* Unblocked LU of the panel A[k0.., k0..k0 + kb), rows are swapped across the whole matrix. */
+        /* False if a pivot is not larger than tolerance, it is still eliminated unless it is 0. */
+        template <typename T>
+        inline bool getrf_panel(T *a, std::size_t n, std::size_t lda, std::size_t *ipiv, std::size_t k0, std::size_t kb, T tolerance) noexcept
+        {
+            bool regular{true};
+            for (std::size_t j{k0}; j < k0 + kb; j++)
+            {
+                /* pivot, the largest element of the column */
+                std::size_t pivot{j};
+                for (std::size_t i{j + 1}; i < n; i++)
+                {
+                    if (std::abs(a[i * lda + j]) > std::abs(a[pivot * lda + j]))
+                        pivot = i;
+                }
+                ipiv[j] = pivot;
+                if (pivot != j)
+                    std::swap_ranges(a + j * lda, a + j * lda + n, a + pivot * lda);
+
+                const auto a_jj = a[j * lda + j];
+                if (std::abs(a_jj) <= tolerance)
+                    regular = false;
+                if (a_jj == T{0})
+                    continue;
+                /* column of L and rank 1 update of the rest of the panel */
+                const auto *u_j = a + j * lda;
+                for (std::size_t i{j + 1}; i < n; i++)
+                {
+                    auto *a_i = a + i * lda;
+                    const auto l_ij = a_i[j] / a_jj;
+                    a_i[j] = l_ij;
+                    for (std::size_t c{j + 1}; c < k0 + kb; c++)
+                    {
+                        a_i[c] -= l_ij * u_j[c];
+                    }
+                }
+            }
+            return regular;
+        }
+    }
+
+    /* Factorise the n x n matrix a in place. False if A is singular to working precision */
+    /* (a pivot within n eps max|A| of zero), the factorisation is still completed. */
+    template <typename T>
+    [[nodiscard]] inline bool getrf(T *a, std::size_t n, std::size_t lda, std::size_t *ipiv, const execution::Policy &policy = execution::automatic)
+    {
+        T largest{0};
+        for (std::size_t i = 0; i < n; i++)
+        {
+            for (std::size_t j = 0; j < n; j++)
+            {
+                largest = std::max(largest, std::abs(a[i * lda + j]));
+            }
+        }
+        const auto tolerance = static_cast<T>(n) * std::numeric_limits<T>::epsilon() * largest;
+
+        bool regular{true};
+        for (std::size_t k0 = 0; k0 < n; k0 += lu_block_size)
+        {
+            const auto kb = std::min(lu_block_size, n - k0);
+            const auto k1 = k0 + kb;
+            regular &= detail::getrf_panel(a, n, lda, ipiv, k0, kb, tolerance);
+            if (k1 == n)
+                break;
+
+            /* U12 = L11^-1 . A12, forward substitution, the columns are independent */
+            const auto trailing = n - k1;
+            execution::run(policy, even_chunks(trailing, kb * kb * trailing < 32 * 32 * 32 ? 1 : 8), [=](std::size_t start, std::size_t end)
+                           {
+                for (std::size_t i{k0 + 1}; i < k1; i++)
+                {
+                    auto *u_i = a + i * lda + k1;
+                    for (std::size_t p{k0}; p < i; p++)
+                    {
+                        const auto l_ip = a[i * lda + p];
+                        const auto *u_p = a + p * lda + k1;
+                        for (std::size_t c{start}; c < end; c++)
+                        {
+                            u_i[c] -= l_ip * u_p[c];
+                        }
+                    }
+                } });
+
+            /* A22 -= L21 . U12 */
+            gemm(a + k1 * lda + k1, lda, a + k1 * lda + k0, lda, a + k0 * lda + k1, lda, trailing, trailing, kb, T{-1}, policy);
+        }
+        return regular;
+    }
+
+    /* Solve A . X = B with the factorisation of getrf, B (n x nrhs) is overwritten with X. */
+    /* The right hand sides are split over the policy's backend. */
+    template <typename T>
+    inline void getrs(const T *lu, std::size_t n, std::size_t lda, const std::size_t *ipiv, T *b, std::size_t nrhs, std::size_t ldb, const execution::Policy &policy = execution::automatic)
+    {
+        execution::run(policy, even_chunks(nrhs, n * n * nrhs < 32 * 32 * 32 ? 1 : 8), [=](std::size_t start, std::size_t end)
+                       {
+            /* B = P . B */
+            for (std::size_t i = 0; i < n; i++)
+            {
+                if (ipiv[i] != i)
+                    std::swap_ranges(b + i * ldb + start, b + i * ldb + end, b + ipiv[i] * ldb + start);
+            }
+            /* L . Y = B */
+            for (std::size_t i = 1; i < n; i++)
+            {
+                for (std::size_t p = 0; p < i; p++)
+                {
+                    const auto l_ip = lu[i * lda + p];
+                    for (std::size_t c{start}; c < end; c++)
+                    {
+                        b[i * ldb + c] -= l_ip * b[p * ldb + c];
+                    }
+                }
+            }
+            /* U . X = Y */
+            for (std::size_t i = n; i-- > 0;)
+            {
+                for (std::size_t p = i + 1; p < n; p++)
+                {
+                    const auto u_ip = lu[i * lda + p];
+                    for (std::size_t c{start}; c < end; c++)
+                    {
+                        b[i * ldb + c] -= u_ip * b[p * ldb + c];
+                    }
+                }
+                const auto u_ii = lu[i * lda + i];
+                for (std::size_t c{start}; c < end; c++)
+                {
+                    b[i * ldb + c] /= u_ii;
+                }
+            } });
+    }
+
+    /* det(A) from the factorisation of getrf */
+    template <typename T>
+    [[nodiscard]] inline T determinant(const T *lu, std::size_t n, std::size_t lda, const std::size_t *ipiv) noexcept
+    {
+        T det{1};
+        for (std::size_t i = 0; i < n; i++)
+        {
+            det *= ipiv[i] != i ? -lu[i * lda + i] : lu[i * lda + i];
+        }
+        return det;
+    }
+
+    /* det(A), A is not modified (the factorisation is made in the scratch arena) */
+    template <typename T>
+    [[nodiscard]] inline T determinant(const T *a, std::size_t n, std::size_t lda, const execution::Policy &policy = execution::automatic)
+    {
+        auto &arena = memory::ScratchArena::local();
+        memory::ScratchArena::Scope scope{arena};
+        auto *lu = arena.allocate<T>(n * n);
+        auto *ipiv = arena.allocate<std::size_t>(n);
+        for (std::size_t i = 0; i < n; i++)
+        {
+            std::copy(a + i * lda, a + i * lda + n, lu + i * n);
+        }
+        (void)getrf(lu, n, n, ipiv, policy);
+        return determinant(lu, n, n, ipiv);
+    }
+
+    /* R = A^-1, false if A is singular */
+    template <typename T>
+    [[nodiscard]] inline bool inverse(const T *a, std::size_t n, std::size_t lda, T *result, std::size_t ldr, const execution::Policy &policy = execution::automatic)
+    {
+        auto &arena = memory::ScratchArena::local();
+        memory::ScratchArena::Scope scope{arena};
+        auto *lu = arena.allocate<T>(n * n);
+        auto *ipiv = arena.allocate<std::size_t>(n);
+        for (std::size_t i = 0; i < n; i++)
+        {
+            std::copy(a + i * lda, a + i * lda + n, lu + i * n);
+        }
+        if (!getrf(lu, n, n, ipiv, policy))
+            return false;
+
+        for (std::size_t i = 0; i < n; i++)
+        {
+            std::fill(result + i * ldr, result + i * ldr + n, T{0});
+            result[i * ldr + i] = T{1};
+        }
+        getrs(lu, n, n, ipiv, result, n, ldr, policy);
+        return true;
+    }
+
+    /* ipiv of an N x N MatrixImpl */
+    template <std::size_t N>
+    using Pivots = std::array<std::size_t, N>;
+
+    template <typename T, std::size_t N>
+    [[nodiscard]] inline bool getrf(MatrixImpl<T, N, N> &a, Pivots<N> &ipiv, const execution::Policy &policy = execution::automatic)
+    {
+        return getrf(a.data()[0].data(), N, N, ipiv.data(), policy);
+    }
+
+    template <typename T, std::size_t N, std::size_t Columns>
+    inline void getrs(const MatrixImpl<T, N, N> &lu, const Pivots<N> &ipiv, MatrixImpl<T, N, Columns> &b, const execution::Policy &policy = execution::automatic)
+    {
+        getrs(lu.data()[0].data(), N, N, ipiv.data(), b.data()[0].data(), Columns, Columns, policy);
+    }
+
+    template <typename T, std::size_t N>
+    [[nodiscard]] inline T determinant(const MatrixImpl<T, N, N> &a, const execution::Policy &policy = execution::automatic)
+    {
+        return determinant(a.data()[0].data(), N, N, policy);
+    }
+
+    template <typename T, std::size_t N>
+    [[nodiscard]] inline bool inverse(const MatrixImpl<T, N, N> &a, MatrixImpl<T, N, N> &result, const execution::Policy &policy = execution::automatic)
+    {
+        return inverse(a.data()[0].data(), N, N, result.data()[0].data(), N, policy);
+    }
+}
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <matrix_operations/matrix_impl.h>
+#include <matrix_operations/matrix_vector.h>
 
 namespace matrix
 {
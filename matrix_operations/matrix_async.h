@@ -0,0 +1,91 @@
+#pragma once
+
+#include <future>
+#include <memory>
+#include <new>
+#include <matrix_operations/matrix.h>
+#include <matrix_operations/allocator.h>
+#include <matrix_operations/solution.h>
+#include <matrix_operations/execution.h>
+#include <matrix_operations/thread_pool.h>
+
+namespace matrix
+{
+    /* Result storage and promise of one asynchronous operation. The chunks write into the */
+    /* heap allocated result and the last chunk to finish hands the pointer to the promise, */
+    /* the matrix itself is never copied. */
+    template <typename Result>
+    struct AsyncState
+    {
+        AsyncState() : result{memory::make_matrix<Result>()}
+        {
+            if (!result)
+                throw std::bad_alloc{};
+        }
+
+        memory::MatrixPtr<Result> result;
+        std::promise<memory::MatrixPtr<Result>> promise{};
+    };
+
+    template <typename Result>
+    using AsyncResult = std::future<memory::MatrixPtr<Result>>;
+
+    namespace detail
+    {
+        /* The chunks run on the shared pool with the policy's priority and never on the caller, */
+        /* unless the policy is serial or the caller is nested (a pool worker, say): the future */
+        /* is then ready on return, and a worker waiting on it can't wait for queued chunks. */
+        template <typename Chunks, typename F, typename Done>
+        inline void run_async(const execution::Policy &policy, const Chunks &chunks, F &&func, Done &&done)
+        {
+            if (execution::resolve(policy) == execution::Backend::serial || execution::nested())
+            {
+                for (const auto &[start, end] : chunks)
+                {
+                    func(start, end);
+                }
+                done();
+                return;
+            }
+            thread_pool::run_chunks_async(execution::shared_pool(), chunks, std::forward<F>(func), std::forward<Done>(done), policy.priority);
+        }
+    }
+
+    /* A . B = R on the thread pool without blocking the caller, the future holds R on the heap. */
+    /* The operands are read by the workers, they must outlive the returned future. */
+    /* Don't wait on a future from a pool worker unless the worker started the operation, */
+    /* its chunks may be queued behind the waiting worker. */
+    template <typename T, std::size_t Rows, std::size_t Columns, std::size_t OtherColumns>
+    [[nodiscard]] inline AsyncResult<MatrixImpl<T, Rows, OtherColumns>> multiply_async(const MatrixImpl<T, Rows, Columns> &a, const MatrixImpl<T, Columns, OtherColumns> &b, const execution::Policy &policy = execution::automatic)
+    {
+        auto state = std::make_shared<AsyncState<MatrixImpl<T, Rows, OtherColumns>>>();
+        auto future = state->promise.get_future();
+
+        detail::run_async(
+            policy, MatrixImpl<T, Rows, Columns>::get_chunks(),
+            [state, result = state->result.get(), &a, &b](std::size_t start, std::size_t end)
+            { a.multiplication_t_aux(*result, b, start, end); },
+            [state]()
+            { state->promise.set_value(std::move(state->result)); });
+
+        return future;
+    }
+
+    /* A . B + C = R on the thread pool without blocking the caller, as multiply_async. */
+    /* The operands are read by the workers, they must outlive the returned future. */
+    template <typename T, std::size_t Rows, std::size_t Columns, std::size_t OtherColumns>
+    [[nodiscard]] inline AsyncResult<MatrixImpl<T, Rows, OtherColumns>> ab_c_async(MatrixImpl<T, Rows, Columns> &a, MatrixImpl<T, Columns, OtherColumns> &b, MatrixImpl<T, Rows, OtherColumns> &c, const execution::Policy &policy = execution::automatic)
+    {
+        auto state = std::make_shared<AsyncState<MatrixImpl<T, Rows, OtherColumns>>>();
+        auto future = state->promise.get_future();
+
+        detail::run_async(
+            policy, MatrixImpl<T, Rows, Columns>::get_chunks(),
+            [state, result = state->result.get(), &a, &b, &c](std::size_t start, std::size_t end)
+            { ab_c_optimised_aux(*result, a, b, c, start, end); },
+            [state]()
+            { state->promise.set_value(std::move(state->result)); });
+
+        return future;
+    }
+}
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <limits>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <matrix_operations/matrix.h>
+
+namespace matrix
+{
+    namespace chain
+    {
+        /* Classic matrix chain dynamic program. */
+        /* Matrix i has the shape dims[i] x dims[i + 1]. */
+        /* cost[i][j] is the minimum number of scalar multiplications for the product of matrices i..j */
+        /* split[i][j] = k means (i..k) . (k + 1..j) is the optimal outermost product */
+        template <std::size_t N>
+        struct Order
+        {
+            std::array<std::array<std::size_t, N>, N> cost{};
+            std::array<std::array<std::size_t, N>, N> split{};
+        };
+
+        template <std::size_t N>
+        constexpr Order<N> optimal_order(const std::array<std::size_t, N + 1> &dims) noexcept
+        {
+            Order<N> order{};
+            /* For each chain length */
+            for (std::size_t length{2}; length <= N; length++)
+            {
+                /* For each chain i..j of that length */
+                for (std::size_t i{0}; i + length <= N; i++)
+                {
+                    std::size_t j = i + length - 1;
+                    order.cost[i][j] = std::numeric_limits<std::size_t>::max();
+                    for (std::size_t k{i}; k < j; k++)
+                    {
+                        auto cost = order.cost[i][k] + order.cost[k + 1][j] + dims[i] * dims[k + 1] * dims[j + 1];
+                        if (cost < order.cost[i][j])
+                        {
+                            order.cost[i][j] = cost;
+                            order.split[i][j] = k;
+                        }
+                    }
+                }
+            }
+            return order;
+        }
+
+        template <typename First, typename... Rest>
+        inline constexpr std::array<std::size_t, sizeof...(Rest) + 2> dims_v{std::remove_cvref_t<First>::rows(), std::remove_cvref_t<First>::columns(), std::remove_cvref_t<Rest>::columns()...};
+
+        /* Optimal order for the chain of matrix types Ms (computed at compile time) */
+        template <typename... Ms>
+        inline constexpr Order<sizeof...(Ms)> order_v{optimal_order<sizeof...(Ms)>(dims_v<Ms...>)};
+
+        /* Scalar multiplications of the optimal order and of plain left to right evaluation */
+        template <typename... Ms>
+        inline constexpr std::size_t cost_v{order_v<Ms...>.cost[0][sizeof...(Ms) - 1]};
+
+        template <typename... Ms>
+        constexpr std::size_t left_to_right_cost() noexcept
+        {
+            constexpr auto dims = dims_v<Ms...>;
+            std::size_t cost{0};
+            for (std::size_t i{1}; i < sizeof...(Ms); i++)
+            {
+                cost += dims[0] * dims[i] * dims[i + 1];
+            }
+            return cost;
+        }
+
+        /* Human readable parenthesization, e.g. "((A0 A1) A2)" */
+        template <std::size_t N>
+        inline std::string parenthesization(const Order<N> &order, std::size_t i = 0, std::size_t j = N - 1)
+        {
+            if (i == j)
+                return "A" + std::to_string(i);
+            auto k = order.split[i][j];
+            return "(" + parenthesization(order, i, k) + " " + parenthesization(order, k + 1, j) + ")";
+        }
+
+        /* Evaluate the product of operands I..J following the split table. */
+        /* Intermediates are prvalues, so each one is constructed directly in the storage */
+        /* of the operand that consumes it (no copies of the nested arrays). */
+        template <std::size_t I, std::size_t J, const auto &Order, typename Operands>
+        constexpr decltype(auto) evaluate(const Operands &operands) noexcept
+        {
+            if constexpr (I == J)
+                return std::get<I>(operands);
+            else
+            {
+                constexpr std::size_t K = Order.split[I][J];
+                return evaluate<I, K, Order>(operands) * evaluate<K + 1, J, Order>(operands);
+            }
+        }
+    }
+
+    /* A . B . C ... evaluated in the order with the fewest scalar multiplications. */
+    /* The order is found at compile time from the shapes of the operands. */
+    template <typename T, std::size_t Rows, std::size_t Columns, typename... Rest>
+    [[nodiscard]] constexpr auto multiply_chain(const MatrixImpl<T, Rows, Columns> &first, const Rest &...rest) noexcept
+    {
+        const auto operands = std::tie(first, rest...);
+        return chain::evaluate<0, sizeof...(Rest), chain::order_v<MatrixImpl<T, Rows, Columns>, Rest...>>(operands);
+    }
+}
@@ -0,0 +1,356 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <algorithm>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <matrix_operations/matrix_impl.h>
+#include <matrix_operations/matrix_impl_2.h>
+
+/* Versioned binary matrix file format. */
+/* [FileHeader][padding up to alignment][raw matrix data] */
+/* The data is the in-memory representation of the matrix, so a read-only mmap of the */
+/* file can be used as a matrix directly, without parsing or copying. */
+namespace matrix_io
+{
+    enum class DType : std::uint32_t
+    {
+        unknown = 0,
+        float32 = 1,
+        float64 = 2,
+        int32 = 3,
+        int64 = 4,
+    };
+
+    enum class Layout : std::uint32_t
+    {
+        row_major = 0,
+        /* matrix_tiled::MatrixImpl, BlockSize x BlockSize tiles stored row major */
+        tiled = 1,
+    };
+
+    template <typename T>
+    constexpr DType dtype_of() noexcept
+    {
+        if constexpr (std::is_same_v<T, float>)
+            return DType::float32;
+        else if constexpr (std::is_same_v<T, double>)
+            return DType::float64;
+        else if constexpr (std::is_same_v<T, std::int32_t>)
+            return DType::int32;
+        else if constexpr (std::is_same_v<T, std::int64_t>)
+            return DType::int64;
+        else
+            return DType::unknown;
+    }
+
+    inline constexpr std::array<char, 4> file_magic{'M', 'T', 'X', 'B'};
+    inline constexpr std::uint32_t file_version{1};
+    /* Data starts on a page boundary so the mapped matrix is page (and cache line) aligned */
+    inline constexpr std::uint64_t default_alignment{4096};
+    /* Writes are issued in chunks of this size */
+    inline constexpr std::size_t write_chunk_size{8 * 1024 * 1024};
+
+    struct FileHeader
+    {
+        std::array<char, 4> magic{file_magic};
+        std::uint32_t version{file_version};
+        DType dtype{DType::unknown};
+        Layout layout{Layout::row_major};
+        std::uint64_t rows{0};
+        std::uint64_t columns{0};
+        /* tile edge for the tiled layout, 0 for row major */
+        std::uint64_t block_size{0};
+        std::uint64_t alignment{default_alignment};
+        std::uint64_t data_offset{0};
+        std::uint64_t data_bytes{0};
+    };
+    static_assert(std::is_trivially_copyable_v<FileHeader>);
+
+    /* The data offset is rounded up to the alignment, a non-zero power of two */
+    constexpr bool valid_alignment(std::uint64_t alignment) noexcept { return std::has_single_bit(alignment); }
+
+    /* rows * columns * element_size, false if the product does not fit (a corrupt header) */
+    constexpr bool data_size(std::uint64_t rows, std::uint64_t columns, std::size_t element_size, std::uint64_t &bytes) noexcept
+    {
+        return !__builtin_mul_overflow(rows, columns, &bytes) && !__builtin_mul_overflow(bytes, element_size, &bytes);
+    }
+
+    /* First multiple of alignment past the header, alignment must be valid */
+    constexpr std::uint64_t data_offset_for(std::uint64_t alignment) noexcept
+    {
+        return (sizeof(FileHeader) + alignment - 1) & ~(alignment - 1);
+    }
+
+    /* Shape and layout description of a matrix type */
+    template <typename M>
+    struct MatrixTraits;
+
+    template <typename T, std::size_t Rows, std::size_t Columns>
+    struct MatrixTraits<matrix::MatrixImpl<T, Rows, Columns>>
+    {
+        using ValueType = T;
+        static constexpr Layout layout{Layout::row_major};
+        static constexpr std::size_t block_size{0};
+        static constexpr std::size_t rows{Rows};
+        static constexpr std::size_t columns{Columns};
+    };
+
+    template <typename T, std::size_t Rows, std::size_t Columns>
+    struct MatrixTraits<matrix_tiled::MatrixImpl<T, Rows, Columns>>
+    {
+        using ValueType = T;
+        static constexpr Layout layout{Layout::tiled};
+        static constexpr std::size_t block_size{matrix_tiled::MatrixImpl<T, Rows, Columns>::BlockSize};
+        static constexpr std::size_t rows{Rows};
+        static constexpr std::size_t columns{Columns};
+    };
+
+    /* The expected header of a file that holds a matrix of type M. */
+    /* An invalid alignment leaves data_offset 0, the writers reject it before. */
+    template <typename M>
+    constexpr FileHeader make_header(std::uint64_t alignment = default_alignment) noexcept
+    {
+        using Traits = MatrixTraits<M>;
+        FileHeader header{};
+        header.dtype = dtype_of<typename Traits::ValueType>();
+        header.layout = Traits::layout;
+        header.rows = Traits::rows;
+        header.columns = Traits::columns;
+        header.block_size = Traits::block_size;
+        header.alignment = alignment;
+        header.data_offset = valid_alignment(alignment) ? data_offset_for(alignment) : 0;
+        header.data_bytes = sizeof(typename M::Data);
+        return header;
+    }
+
+    /* Header describes the same matrix type (ignoring alignment and offset) */
+    inline bool compatible(const FileHeader &lhs, const FileHeader &rhs) noexcept
+    {
+        return lhs.magic == rhs.magic && lhs.version == rhs.version && lhs.dtype == rhs.dtype && lhs.layout == rhs.layout &&
+               lhs.rows == rhs.rows && lhs.columns == rhs.columns && lhs.block_size == rhs.block_size && lhs.data_bytes == rhs.data_bytes;
+    }
+
+    inline bool write_all(int fd, const char *data, std::size_t bytes) noexcept
+    {
+        while (bytes > 0)
+        {
+            auto written = ::write(fd, data, std::min(bytes, write_chunk_size));
+            if (written < 0 && errno == EINTR)
+                continue;
+            if (written <= 0)
+                return false;
+            data += written;
+            bytes -= static_cast<std::size_t>(written);
+        }
+        return true;
+    }
+
+    /* Write header + raw data with large sequential writes. Returns false on any I/O error. */
+    inline bool write_raw(const std::string &path, const FileHeader &header, const void *data) noexcept
+    {
+        int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0)
+            return false;
+
+        /* header and padding go out in a single write */
+        std::string prefix(header.data_offset, '\0');
+        std::memcpy(prefix.data(), &header, sizeof(header));
+        bool ok = write_all(fd, prefix.data(), prefix.size()) &&
+                  write_all(fd, static_cast<const char *>(data), header.data_bytes);
+        ok = (::close(fd) == 0) && ok;
+        return ok;
+    }
+
+    template <typename M>
+    inline bool write_matrix(const std::string &path, const M &m, std::uint64_t alignment = default_alignment) noexcept
+    {
+        static_assert(std::is_trivially_copyable_v<typename M::Data>);
+        if (!valid_alignment(alignment))
+            return false;
+        return write_raw(path, make_header<M>(alignment), &m.data());
+    }
+
+    /* Read-only mapping of a matrix file. Move only, unmapped on destruction. */
+    class MappedFile
+    {
+    public:
+        MappedFile() = default;
+        explicit MappedFile(const std::string &path) noexcept { open(path); }
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+        MappedFile(MappedFile &&other) noexcept { swap(other); }
+        MappedFile &operator=(MappedFile &&other) noexcept
+        {
+            MappedFile tmp{std::move(other)};
+            swap(tmp);
+            return *this;
+        }
+        ~MappedFile() { close(); }
+
+        bool open(const std::string &path) noexcept
+        {
+            close();
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0)
+                return false;
+
+            struct stat st{};
+            if (::fstat(fd, &st) == 0 && static_cast<std::size_t>(st.st_size) >= sizeof(FileHeader))
+            {
+                auto *addr = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+                if (addr != MAP_FAILED)
+                {
+                    base_ = static_cast<const char *>(addr);
+                    size_ = static_cast<std::size_t>(st.st_size);
+                }
+            }
+            /* the mapping stays valid after the descriptor is closed */
+            ::close(fd);
+
+            if (!base_)
+                return false;
+
+            std::memcpy(&header_, base_, sizeof(header_));
+            /* data_offset + data_bytes could wrap, the data is checked against the room after the offset */
+            if (!(header_.magic == file_magic && header_.version == file_version && valid_alignment(header_.alignment) &&
+                  header_.data_offset % header_.alignment == 0 && header_.data_offset >= sizeof(FileHeader) &&
+                  header_.data_offset <= size_ && header_.data_bytes <= size_ - header_.data_offset))
+            {
+                close();
+            }
+            return valid();
+        }
+
+        void close() noexcept
+        {
+            if (base_)
+            {
+                ::munmap(const_cast<char *>(base_), size_);
+            }
+            base_ = nullptr;
+            size_ = 0;
+            header_ = {};
+        }
+
+        /* Hint the kernel about the access pattern (e.g. MADV_SEQUENTIAL, MADV_WILLNEED) */
+        void advise(int advice) const noexcept
+        {
+            if (base_)
+                ::madvise(const_cast<char *>(base_), size_, advice);
+        }
+
+        [[nodiscard]] bool valid() const noexcept { return base_ != nullptr; }
+        [[nodiscard]] const FileHeader &header() const noexcept { return header_; }
+        [[nodiscard]] const void *data() const noexcept { return base_ + header_.data_offset; }
+
+    private:
+        void swap(MappedFile &other) noexcept
+        {
+            std::swap(base_, other.base_);
+            std::swap(size_, other.size_);
+            std::swap(header_, other.header_);
+        }
+
+        const char *base_{nullptr};
+        std::size_t size_{0};
+        FileHeader header_{};
+    };
+
+    /* Zero copy view of a matrix file as a matrix of type M. */
+    /* valid() is false if the file does not exist or holds a different dtype, shape or layout. */
+    template <typename M>
+    class MappedMatrix
+    {
+    public:
+        MappedMatrix() = default;
+        explicit MappedMatrix(const std::string &path) noexcept { open(path); }
+
+        bool open(const std::string &path) noexcept
+        {
+            /* the matrix types hold nothing but their nested arrays */
+            static_assert(sizeof(M) == sizeof(typename M::Data));
+            /* compatible() pins rows, columns and data_bytes to M, the size check guards the */
+            /* product like MappedMatrixView does (data_bytes of a tiled M may include padding) */
+            std::uint64_t bytes{0};
+            if (file_.open(path) && !(compatible(file_.header(), make_header<M>()) && file_.header().alignment % alignof(M) == 0 &&
+                                      data_size(file_.header().rows, file_.header().columns, sizeof(typename MatrixTraits<M>::ValueType), bytes) &&
+                                      bytes <= file_.header().data_bytes))
+            {
+                file_.close();
+            }
+            return valid();
+        }
+
+        [[nodiscard]] bool valid() const noexcept { return file_.valid(); }
+        [[nodiscard]] const FileHeader &header() const noexcept { return file_.header(); }
+
+        /* The matrix lives in the page cache, it is read-only */
+        [[nodiscard]] const M &matrix() const noexcept { return *static_cast<const M *>(file_.data()); }
+
+    private:
+        MappedFile file_{};
+    };
+
+    /* Runtime shaped view of a row major matrix file, for shapes that are not known at compile time */
+    template <typename T>
+    class MappedMatrixView
+    {
+    public:
+        MappedMatrixView() = default;
+        explicit MappedMatrixView(const std::string &path) noexcept { open(path); }
+
+        bool open(const std::string &path) noexcept
+        {
+            if (file_.open(path))
+            {
+                const auto &header = file_.header();
+                std::uint64_t bytes{0};
+                if (header.dtype != dtype_of<T>() || header.layout != Layout::row_major ||
+                    !data_size(header.rows, header.columns, sizeof(T), bytes) || header.data_bytes != bytes || header.alignment % alignof(T) != 0)
+                {
+                    file_.close();
+                }
+            }
+            return valid();
+        }
+
+        [[nodiscard]] bool valid() const noexcept { return file_.valid(); }
+        [[nodiscard]] const FileHeader &header() const noexcept { return file_.header(); }
+        [[nodiscard]] std::size_t rows() const noexcept { return file_.header().rows; }
+        [[nodiscard]] std::size_t columns() const noexcept { return file_.header().columns; }
+
+        [[nodiscard]] const T *data() const noexcept { return static_cast<const T *>(file_.data()); }
+        [[nodiscard]] const T *row(std::size_t row) const noexcept { return data() + row * columns(); }
+        [[nodiscard]] const T &operator()(std::size_t row, std::size_t column) const noexcept { return data()[row * columns() + column]; }
+
+    private:
+        MappedFile file_{};
+    };
+
+    /* Writer for runtime shaped row major data */
+    template <typename T>
+    inline bool write_matrix(const std::string &path, const T *data, std::size_t rows, std::size_t columns, std::uint64_t alignment = default_alignment) noexcept
+    {
+        if (!valid_alignment(alignment))
+            return false;
+        FileHeader header{};
+        header.dtype = dtype_of<T>();
+        header.rows = rows;
+        header.columns = columns;
+        header.alignment = alignment;
+        header.data_offset = data_offset_for(alignment);
+        header.data_bytes = rows * columns * sizeof(T);
+        return write_raw(path, header, data);
+    }
+}
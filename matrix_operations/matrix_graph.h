@@ -0,0 +1,95 @@
+#pragma once
+
+#include <functional>
+#include <matrix_operations/matrix.h>
+#include <matrix_operations/solution.h>
+#include <matrix_operations/task_graph.h>
+
+/* Matrix operations as task graph nodes. */
+/* Every operation is split into one node per row chunk plus an empty join node. */
+/* The join node id is returned and is used as the dependency of later operations, */
+/* so chunks of independent products are interleaved on the pool. */
+/* Matrices are captured by reference and must outlive every run of the graph. */
+namespace matrix
+{
+    using NodeId = thread_pool::TaskGraph::NodeId;
+    using Dependencies = thread_pool::TaskGraph::Dependencies;
+
+    /* Add func(start, end) for each row chunk of matrix type M, followed by the join node */
+    template <typename M, typename F>
+    inline NodeId add_chunked(thread_pool::TaskGraph &graph, F func, const Dependencies &dependencies)
+    {
+        Dependencies chunk_nodes{};
+        for (const auto &[start, end] : M::get_chunks())
+        {
+            if (start == end)
+                continue;
+            chunk_nodes.push_back(graph.add([func, start, end]()
+                                            { func(start, end); },
+                                            dependencies));
+        }
+        return graph.add([]() {}, chunk_nodes);
+    }
+
+    /* R = A . B */
+    template <typename T, std::size_t Rows, std::size_t Columns, std::size_t OtherColumns>
+    inline NodeId add_multiplication(thread_pool::TaskGraph &graph, MatrixImpl<T, Rows, OtherColumns> &result, const MatrixImpl<T, Rows, Columns> &a, const MatrixImpl<T, Columns, OtherColumns> &b, const Dependencies &dependencies = {})
+    {
+        return add_chunked<MatrixImpl<T, Rows, Columns>>(
+            graph, [&result, &a, &b](std::size_t start, std::size_t end)
+            {
+                /* multiplication_t_aux accumulates, clear the rows of this chunk first */
+                for (std::size_t i{start}; i < end; i++)
+                {
+                    result.data()[i].fill(T{0});
+                }
+                a.multiplication_t_aux(result, b, start, end); },
+            dependencies);
+    }
+
+    /* R = A . B + C */
+    template <typename T, std::size_t Rows, std::size_t Columns, std::size_t OtherColumns>
+    inline NodeId add_ab_c(thread_pool::TaskGraph &graph, MatrixImpl<T, Rows, OtherColumns> &result, MatrixImpl<T, Rows, Columns> &a, MatrixImpl<T, Columns, OtherColumns> &b, MatrixImpl<T, Rows, OtherColumns> &c, const Dependencies &dependencies = {})
+    {
+        return add_chunked<MatrixImpl<T, Rows, Columns>>(
+            graph, [&result, &a, &b, &c](std::size_t start, std::size_t end)
+            {
+                for (std::size_t i{start}; i < end; i++)
+                {
+                    result.data()[i].fill(T{0});
+                }
+                ab_c_optimised_aux(result, a, b, c, start, end); },
+            dependencies);
+    }
+
+    /* R = op(A, B) element wise, e.g. std::plus<>{} */
+    template <typename T, std::size_t Rows, std::size_t Columns, typename Op>
+    inline NodeId add_element_wise(thread_pool::TaskGraph &graph, MatrixImpl<T, Rows, Columns> &result, const MatrixImpl<T, Rows, Columns> &a, const MatrixImpl<T, Rows, Columns> &b, Op op, const Dependencies &dependencies = {})
+    {
+        return add_chunked<MatrixImpl<T, Rows, Columns>>(
+            graph, [&result, &a, &b, op](std::size_t start, std::size_t end)
+            {
+                for (std::size_t row{start}; row < end; row++)
+                {
+                    for (std::size_t column{0}; column < Columns; column++)
+                    {
+                        result.data()[row][column] = op(a.data()[row][column], b.data()[row][column]);
+                    }
+                } },
+            dependencies);
+    }
+
+    /* R = A + B */
+    template <typename T, std::size_t Rows, std::size_t Columns>
+    inline NodeId add_addition(thread_pool::TaskGraph &graph, MatrixImpl<T, Rows, Columns> &result, const MatrixImpl<T, Rows, Columns> &a, const MatrixImpl<T, Rows, Columns> &b, const Dependencies &dependencies = {})
+    {
+        return add_element_wise(graph, result, a, b, std::plus<T>{}, dependencies);
+    }
+
+    /* R = A - B */
+    template <typename T, std::size_t Rows, std::size_t Columns>
+    inline NodeId add_subtraction(thread_pool::TaskGraph &graph, MatrixImpl<T, Rows, Columns> &result, const MatrixImpl<T, Rows, Columns> &a, const MatrixImpl<T, Rows, Columns> &b, const Dependencies &dependencies = {})
+    {
+        return add_element_wise(graph, result, a, b, std::minus<T>{}, dependencies);
+    }
+}
@@ -8,6 +8,7 @@
 #include <latch>
 #include <omp.h>
 #include <matrix_operations/thread_pool.h>
+#include <matrix_operations/execution.h>
 
 namespace matrix
 {
@@ -69,9 +70,18 @@ namespace matrix
         template <std::size_t OtherColumns>
         [[nodiscard]] MatrixImpl<T, Rows, OtherColumns> multiplication_tn(const MatrixImpl<T, Columns, OtherColumns> &other) const noexcept;
 
-        /* Cache optimised multi threaded (tn) implementation */
+        /* Cache optimised multi threaded (tn) implementation on the thread pool, the caller computes a share */
+        template <std::size_t OtherColumns>
+        [[nodiscard]] MatrixImpl<T, Rows, OtherColumns> multiplication_tn_pool(const MatrixImpl<T, Columns, OtherColumns> &other, thread_pool::ForkJoin mode = thread_pool::ForkJoin::caller_participates, thread_pool::Priority priority = thread_pool::Priority::normal) const noexcept;
+
+        /* Cache optimised implementation, the chunks run on the policy's backend (execution.h) */
         template <std::size_t OtherColumns>
-        [[nodiscard]] MatrixImpl<T, Rows, OtherColumns> multiplication_tn_pool(const MatrixImpl<T, Columns, OtherColumns> &other) const noexcept;
+        [[nodiscard]] MatrixImpl<T, Rows, OtherColumns> multiplication(const MatrixImpl<T, Columns, OtherColumns> &other, const execution::Policy &policy = execution::automatic) const noexcept;
+
+        /* Cancellable variant, stops between row blocks once the token is stopped or the deadline passed. */
+        /* result is only valid if the outcome is ok() */
+        template <std::size_t OtherColumns>
+        [[nodiscard]] execution::Outcome multiplication(MatrixImpl<T, Rows, OtherColumns> &result, const MatrixImpl<T, Columns, OtherColumns> &other, const execution::Cancellation &cancellation, const execution::Policy &policy = execution::automatic) const noexcept;
 
         template <std::size_t OtherColumns>
         constexpr void multiplication_t_aux(MatrixImpl<T, Rows, OtherColumns> &result, const MatrixImpl<T, Columns, OtherColumns> &other, std::size_t start, std::size_t end) const noexcept;
@@ -89,6 +99,9 @@ namespace matrix
         /* single threaded (t1) implementation for rvalues */
         [[nodiscard]] constexpr MatrixImpl addition(const MatrixImpl &other) && noexcept;
 
+        /* the chunks run on the policy's backend (execution.h) */
+        [[nodiscard]] MatrixImpl addition(const MatrixImpl &other, const execution::Policy &policy) const & noexcept;
+
         /* multi threaded (tn) implementation */
         [[nodiscard]] MatrixImpl addition_tn(const MatrixImpl &other) const & noexcept;
         /* multi threaded (tn) implementation for rvalues */
@@ -182,10 +195,14 @@ namespace matrix
     {
         if constexpr (Rows * Columns * OtherColumns < 8 * 8 * 8)
             return multiplication_naive(other);
-        else if constexpr (Rows * Columns * OtherColumns < 128 * 128 * 128)
-            return multiplication_omp(other);
+        /* matrix . vector and vector . matrix have dedicated kernels (matrix_vector.h) */
+        else if constexpr (OtherColumns == 1)
+            return gemv(*this, other);
+        else if constexpr (Rows == 1)
+            return gevm(*this, other);
+        /* the process wide default backend, one thread team for every operation */
         else
-            return multiplication_tn(other);
+            return multiplication(other, execution::automatic);
     }
 
     /* Not cache friendly */
@@ -269,55 +286,49 @@ namespace matrix
     /* Execute multiplication_t_aux for each chunk in a separate thread. */
     /* Run threads on isolated CPUs for better performance. */
     /* Utilize CPUs within a single NUMA node. Cross-NUMA memory access is expensive. */
+    /* Threads are only created within the global thread budget, nested calls are serial (execution.h) */
     template <typename T, std::size_t Rows, std::size_t Columns>
     template <std::size_t OtherColumns>
     MatrixImpl<T, Rows, OtherColumns> MatrixImpl<T, Rows, Columns>::multiplication_tn(const MatrixImpl<T, Columns, OtherColumns> &other) const noexcept
     {
-        MatrixImpl<T, Rows, OtherColumns> result{};
-        /* jthread is not supported in Clang 14 yet, so std::thread is being used instead. */
-        std::vector<std::thread> threads{};
-        for (auto &chunk : chunks_)
-        {
-            /* thread creation is costly, use thread pools for better performance */
-            threads.emplace_back([this, &result, &other, &chunk]()
-                                 { multiplication_t_aux(result, other, chunk.first, chunk.second); });
-        }
-
-        for (auto &thread : threads)
-        {
-            thread.join();
-        }
+        return multiplication(other, execution::threads);
+    }
 
-        return result;
+    /* The submitting thread claims chunks alongside the workers (fork/join) instead of idling on a latch */
+    template <typename T, std::size_t Rows, std::size_t Columns>
+    template <std::size_t OtherColumns>
+    MatrixImpl<T, Rows, OtherColumns> MatrixImpl<T, Rows, Columns>::multiplication_tn_pool(const MatrixImpl<T, Columns, OtherColumns> &other, thread_pool::ForkJoin mode, thread_pool::Priority priority) const noexcept
+    {
+        return multiplication(other, execution::Policy{execution::Backend::pool, mode, priority});
     }
 
     template <typename T, std::size_t Rows, std::size_t Columns>
     template <std::size_t OtherColumns>
-    MatrixImpl<T, Rows, OtherColumns> MatrixImpl<T, Rows, Columns>::multiplication_tn_pool(const MatrixImpl<T, Columns, OtherColumns> &other) const noexcept
+    MatrixImpl<T, Rows, OtherColumns> MatrixImpl<T, Rows, Columns>::multiplication(const MatrixImpl<T, Columns, OtherColumns> &other, const execution::Policy &policy) const noexcept
     {
         MatrixImpl<T, Rows, OtherColumns> result{};
-
-        auto &tp = thread_pool::ThreadPoolInstance::get_instance();
-        auto &workers = tp.workers_;
-
-        auto thread_count = static_cast<std::ptrdiff_t>(workers.size());
-        std::latch work_complete{thread_count};
-
-        for (std::size_t i = 0; i < workers.size(); i++)
-        {
-            auto [start, end] = chunks_[i];
-            auto task = std::make_shared<thread_pool::Task>([this, &result, &other, start, end, &work_complete]()
-                                                            {
-                multiplication_t_aux(result, other, start, end);
-                work_complete.count_down(); });
-            const auto &worker = workers[i];
-            worker->enqueue(task);
-        }
-
-        work_complete.wait();
+        execution::run(policy, chunks_, [this, &result, &other](std::size_t start, std::size_t end)
+                       { multiplication_t_aux(result, other, start, end); });
         return result;
     }
 
+    template <typename T, std::size_t Rows, std::size_t Columns>
+    template <std::size_t OtherColumns>
+    execution::Outcome MatrixImpl<T, Rows, Columns>::multiplication(MatrixImpl<T, Rows, OtherColumns> &result, const MatrixImpl<T, Columns, OtherColumns> &other, const execution::Cancellation &cancellation, const execution::Policy &policy) const noexcept
+    {
+        /* multiplication_t_aux accumulates, each block zeroes its rows first (no whole matrix */
+        /* temporary, and rows of skipped blocks are not touched) */
+        return execution::run(
+            policy, chunks_, [this, &result, &other](std::size_t start, std::size_t end)
+            {
+                for (std::size_t i{start}; i < end; i++)
+                {
+                    result.data()[i].fill(T{0});
+                }
+                multiplication_t_aux(result, other, start, end); },
+            cancellation);
+    }
+
     /* This implimentation seems to have a bug */
     template <typename T, std::size_t Rows, std::size_t Columns>
     template <std::size_t OtherColumns>
@@ -359,8 +370,10 @@ namespace matrix
         std::size_t i{0};
         std::size_t j{0};
         std::size_t k{0};
-        omp_set_num_threads(number_of_worker_threads());
-#pragma omp parallel for private(i, j, k)
+        /* team size for this region only, the global OpenMP state is left alone. */
+        /* Serial when nested or when the thread budget is used up. */
+        execution::Team team{execution::default_threads()};
+#pragma omp parallel for private(i, j, k) num_threads(static_cast<int>(team.threads())) if (team.threads() > 1)
         for (i = 0; i < rows(); i++)
         {
             /* For each column in A (row in B) */
@@ -434,28 +447,22 @@ namespace matrix
         return *this;
     }
 
-    /* multi threaded (tn) implementation */
     template <typename T, std::size_t Rows, std::size_t Columns>
-    MatrixImpl<T, Rows, Columns> MatrixImpl<T, Rows, Columns>::addition_tn(const MatrixImpl &other) const & noexcept
+    MatrixImpl<T, Rows, Columns> MatrixImpl<T, Rows, Columns>::addition(const MatrixImpl &other, const execution::Policy &policy) const & noexcept
     {
         MatrixImpl result{};
-        /* jthread is not supported in Clang 14 yet, so std::thread is being used instead. */
-        std::vector<std::thread> threads{};
-        for (auto &chunk : chunks_)
-        {
-            /* thread creation is costly, use thread pools for better performance */
-            threads.emplace_back([this, &result, &other, &chunk]()
-                                 { addition_tn_aux(result, other, chunk.first, chunk.second); });
-        }
-
-        for (auto &thread : threads)
-        {
-            thread.join();
-        }
-
+        execution::run(policy, chunks_, [this, &result, &other](std::size_t start, std::size_t end)
+                       { addition_tn_aux(result, other, start, end); });
         return result;
     }
 
+    /* multi threaded (tn) implementation */
+    template <typename T, std::size_t Rows, std::size_t Columns>
+    MatrixImpl<T, Rows, Columns> MatrixImpl<T, Rows, Columns>::addition_tn(const MatrixImpl &other) const & noexcept
+    {
+        return addition(other, execution::threads);
+    }
+
     template <typename T, std::size_t Rows, std::size_t Columns>
     constexpr MatrixImpl<T, Rows, Columns> MatrixImpl<T, Rows, Columns>::operator-(const MatrixImpl &other) const & noexcept
     {
@@ -485,3 +492,6 @@ namespace matrix
         return *this;
     }
 }
+
+/* gemv and gevm of operator*, after MatrixImpl so this header compiles on its own */
+#include <matrix_operations/matrix_vector.h>
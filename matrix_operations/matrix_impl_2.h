@@ -51,7 +51,8 @@ namespace matrix_tiled
         template <std::size_t OtherColumns>
         constexpr MatrixImpl<T, Rows, OtherColumns> multiplication_tiled(const MatrixImpl<T, Columns, OtherColumns> &other) const noexcept;
 
-        constexpr void multiplication_tiled_aux(const MatrixImpl<T, Rows, Columns>::Block &a, const MatrixImpl<T, Rows, Columns>::Block &b, MatrixImpl<T, Rows, Columns>::Block &r) const noexcept;
+        /* r += a * b for a single tile (shared with the block sparse variant) */
+        static constexpr void multiplication_tiled_aux(const MatrixImpl<T, Rows, Columns>::Block &a, const MatrixImpl<T, Rows, Columns>::Block &b, MatrixImpl<T, Rows, Columns>::Block &r) noexcept;
 
         auto operator<=>(const MatrixImpl &) const = default;
 
@@ -116,7 +117,7 @@ namespace matrix_tiled
                 {
                     sum += data_row_column(row, column) * other.data_row_column(column, other_col);
                 }
-                result.data_row_column(row, other_col) = sum;z
+                result.data_row_column(row, other_col) = sum;
             }
         }
 
@@ -159,7 +160,7 @@ namespace matrix_tiled
     // }
 
     template <typename T, std::size_t Rows, std::size_t Columns>
-    constexpr void MatrixImpl<T, Rows, Columns>::multiplication_tiled_aux(const MatrixImpl<T, Rows, Columns>::Block &a, const MatrixImpl<T, Rows, Columns>::Block &b, MatrixImpl<T, Rows, Columns>::Block &r) const noexcept
+    constexpr void MatrixImpl<T, Rows, Columns>::multiplication_tiled_aux(const MatrixImpl<T, Rows, Columns>::Block &a, const MatrixImpl<T, Rows, Columns>::Block &b, MatrixImpl<T, Rows, Columns>::Block &r) noexcept
     {
         for (std::size_t x = 0; x < BlockSize; x++)
         {
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <new>
+#include <matrix_operations/matrix.h>
+#include <matrix_operations/packed_matrix.h>
+#include <matrix_operations/allocator.h>
+
+/* A^n by binary exponentiation (square and multiply), log2(n) squarings and at most as */
+/* many multiplications. Every product is written into one of two preallocated buffers */
+/* (ping-pong) instead of a new MatrixImpl, and the current power of A is packed once per */
+/* squaring (packed_matrix.h), so both products of a step use the panel kernel. */
+/* When only A^n . x is needed, pow_gemv applies A n times as GEMV: n N^2 instead of */
+/* about 2 log2(n) N^3 flops, the better choice unless n is in the order of N log2(n). */
+namespace matrix
+{
+    /* Buffers of pow, reused between calls so repeated powers don't allocate */
+    template <typename T, std::size_t N>
+    class PowerWorkspace
+    {
+    public:
+        using M = MatrixImpl<T, N, N>;
+
+        PowerWorkspace() : buffers_{allocate(), allocate()} {}
+
+        [[nodiscard]] M &buffer(std::size_t i) noexcept { return *buffers_[i]; }
+        [[nodiscard]] PackedMatrix<T, N, N> &packed() noexcept { return packed_; }
+
+    private:
+        static memory::MatrixPtr<M> allocate()
+        {
+            auto m = memory::make_matrix<M>();
+            if (!m)
+                throw std::bad_alloc{};
+            return m;
+        }
+
+        std::array<memory::MatrixPtr<M>, 2> buffers_;
+        PackedMatrix<T, N, N> packed_{};
+    };
+
+    namespace detail
+    {
+        /* r = a . b, the chunks of a run on the policy's backend */
+        template <typename T, std::size_t N>
+        inline void packed_product(MatrixImpl<T, N, N> &r, const MatrixImpl<T, N, N> &a, const PackedMatrix<T, N, N> &b, const execution::Policy &policy)
+        {
+            execution::run(policy, MatrixImpl<T, N, N>::get_chunks(), [&r, &a, &b](std::size_t start, std::size_t end)
+                           { packed_multiplication_aux(r, a, b, start, end); });
+        }
+    }
+
+    /* result = A^n, result must not be A */
+    template <typename T, std::size_t N>
+    inline void pow(MatrixImpl<T, N, N> &result, const MatrixImpl<T, N, N> &a, std::size_t n, PowerWorkspace<T, N> &workspace, const execution::Policy &policy = execution::automatic)
+    {
+        using M = MatrixImpl<T, N, N>;
+        if (n == 0)
+        {
+            /* in place, an N x N temporary would not fit on the stack for large N */
+            for (std::size_t i = 0; i < N; i++)
+            {
+                result.data()[i].fill(T{0});
+                result.data()[i][i] = T{1};
+            }
+            return;
+        }
+
+        std::array<M *, 3> buffers{&result, &workspace.buffer(0), &workspace.buffer(1)};
+        /* A^(2^k) and the product of the powers for the bits of n seen so far */
+        const M *base = &a;
+        M *accumulator = nullptr;
+        /* a buffer holding neither base nor the accumulator */
+        auto spare = [&buffers, &base, &accumulator]()
+        {
+            for (auto *buffer : buffers)
+            {
+                if (buffer != base && buffer != accumulator)
+                    return buffer;
+            }
+            return buffers[0];
+        };
+
+        auto &packed = workspace.packed();
+        while (true)
+        {
+            const bool last = (n >> 1) == 0;
+            /* base . base and accumulator . base both read base packed */
+            if (!last || (n & 1 && accumulator))
+                packed.pack(*base, Packing::panels);
+
+            if (n & 1)
+            {
+                auto *target = spare();
+                if (accumulator)
+                    detail::packed_product(*target, *accumulator, packed, policy);
+                else
+                    *target = *base;
+                accumulator = target;
+            }
+            n >>= 1;
+            if (n == 0)
+                break;
+
+            auto *target = spare();
+            detail::packed_product(*target, *base, packed, policy);
+            base = target;
+        }
+
+        if (accumulator != &result)
+            result = *accumulator;
+    }
+
+    template <typename T, std::size_t N>
+    inline void pow(MatrixImpl<T, N, N> &result, const MatrixImpl<T, N, N> &a, std::size_t n, const execution::Policy &policy = execution::automatic)
+    {
+        PowerWorkspace<T, N> workspace{};
+        pow(result, a, n, workspace, policy);
+    }
+
+    /* y = A^n . x as n GEMVs, ping-ponging between y and one vector of workspace */
+    template <typename T, std::size_t N>
+    inline void pow_gemv(MatrixImpl<T, N, 1> &y, const MatrixImpl<T, N, N> &a, std::size_t n, const MatrixImpl<T, N, 1> &x, const execution::Policy &policy = execution::automatic)
+    {
+        if (n == 0)
+        {
+            y = x;
+            return;
+        }
+
+        MatrixImpl<T, N, 1> workspace{};
+        const MatrixImpl<T, N, 1> *current = &x;
+        for (std::size_t step = 0; step < n; step++)
+        {
+            /* the last step writes y */
+            auto *target = (n - 1 - step) % 2 == 0 ? &y : &workspace;
+            execution::run(policy, MatrixImpl<T, N, N>::get_chunks(), [target, &a, current](std::size_t start, std::size_t end)
+                           { gemv_aux(*target, a, *current, start, end); });
+            current = target;
+        }
+    }
+}
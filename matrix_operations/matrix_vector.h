@@ -0,0 +1,178 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <matrix_operations/execution.h>
+#include <matrix_operations/matrix_impl.h>
+
+namespace matrix
+{
+    /* Number of rows of A that share a single pass over x */
+    inline constexpr std::size_t gemv_rows_per_pass{4};
+
+    /* A . x = y (GEMV) */
+    /* Each row of A is read exactly once, as a dot product with x. */
+    /* gemv_rows_per_pass rows are reduced together so every load of x is reused. */
+    template <typename T, std::size_t Rows, std::size_t Columns>
+    constexpr void gemv_aux(MatrixImpl<T, Rows, 1> &result, const MatrixImpl<T, Rows, Columns> &a, const MatrixImpl<T, Columns, 1> &x, std::size_t start, std::size_t end) noexcept
+    {
+        end = std::min(end, Rows);
+        start = std::min(start, end);
+        const auto groups_end = start + (end - start) / gemv_rows_per_pass * gemv_rows_per_pass;
+        /* For each group of rows in A from start to end of this chunk */
+        for (std::size_t i{start}; i < groups_end; i += gemv_rows_per_pass)
+        {
+            T sum[gemv_rows_per_pass]{};
+            for (std::size_t k = 0; k < Columns; k++)
+            {
+                auto x_k = x.data()[k][0];
+                for (std::size_t r = 0; r < gemv_rows_per_pass; r++)
+                {
+                    sum[r] += a.data()[i + r][k] * x_k;
+                }
+            }
+            for (std::size_t r = 0; r < gemv_rows_per_pass; r++)
+            {
+                result.data()[i + r][0] = sum[r];
+            }
+        }
+
+        /* Remaining rows of this chunk */
+        for (std::size_t i{groups_end}; i < end; i++)
+        {
+            const auto &a_i = a.data()[i];
+            T sum{0};
+            for (std::size_t k = 0; k < Columns; k++)
+            {
+                sum += a_i[k] * x.data()[k][0];
+            }
+            result.data()[i][0] = sum;
+        }
+    }
+
+    /* x . A = y (GEVM) for columns start to end of A */
+    /* Rows of A are streamed in order and accumulated into y (axpy per row) */
+    template <typename T, std::size_t Rows, std::size_t Columns>
+    constexpr void gevm_aux(MatrixImpl<T, 1, Columns> &result, const MatrixImpl<T, 1, Rows> &x, const MatrixImpl<T, Rows, Columns> &a, std::size_t start, std::size_t end) noexcept
+    {
+        auto &y = result.data()[0];
+        for (std::size_t k{0}; k < Rows; k++)
+        {
+            auto x_k = x.data()[0][k];
+            const auto &a_k = a.data()[k];
+            for (std::size_t j = start; j < end; j++)
+            {
+                y[j] += x_k * a_k[j];
+            }
+        }
+    }
+
+    /* Batched GEMV. Each row of xs is one vector, row b of the result is A . xs[b] */
+    /* A row of A stays in cache while it is applied to every vector in the batch */
+    template <typename T, std::size_t Rows, std::size_t Columns, std::size_t Batch>
+    constexpr void gemv_batched_aux(MatrixImpl<T, Batch, Rows> &result, const MatrixImpl<T, Rows, Columns> &a, const MatrixImpl<T, Batch, Columns> &xs, std::size_t start, std::size_t end) noexcept
+    {
+        for (std::size_t i{start}; i < end; i++)
+        {
+            const auto &a_i = a.data()[i];
+            for (std::size_t b{0}; b < Batch; b++)
+            {
+                const auto &x_b = xs.data()[b];
+                T sum{0};
+                for (std::size_t k = 0; k < Columns; k++)
+                {
+                    sum += a_i[k] * x_b[k];
+                }
+                result.data()[b][i] = sum;
+            }
+        }
+    }
+
+    /* single threaded (t1) implementation */
+    template <typename T, std::size_t Rows, std::size_t Columns>
+    [[nodiscard]] constexpr MatrixImpl<T, Rows, 1> gemv_t1(const MatrixImpl<T, Rows, Columns> &a, const MatrixImpl<T, Columns, 1> &x) noexcept
+    {
+        MatrixImpl<T, Rows, 1> result{};
+        gemv_aux(result, a, x, 0, Rows);
+        return result;
+    }
+
+    /* multi threaded implementation, rows of A are split into the chunks of A, */
+    /* the chunks run on the policy's backend (execution.h) */
+    template <typename T, std::size_t Rows, std::size_t Columns>
+    [[nodiscard]] MatrixImpl<T, Rows, 1> gemv_tn_pool(const MatrixImpl<T, Rows, Columns> &a, const MatrixImpl<T, Columns, 1> &x, const execution::Policy &policy = execution::automatic) noexcept
+    {
+        MatrixImpl<T, Rows, 1> result{};
+        execution::run(policy, MatrixImpl<T, Rows, Columns>::get_chunks(), [&result, &a, &x](std::size_t start, std::size_t end)
+                       { gemv_aux(result, a, x, start, end); });
+        return result;
+    }
+
+    /* single threaded (t1) implementation */
+    template <typename T, std::size_t Rows, std::size_t Columns>
+    [[nodiscard]] constexpr MatrixImpl<T, 1, Columns> gevm_t1(const MatrixImpl<T, 1, Rows> &x, const MatrixImpl<T, Rows, Columns> &a) noexcept
+    {
+        MatrixImpl<T, 1, Columns> result{};
+        gevm_aux(result, x, a, 0, Columns);
+        return result;
+    }
+
+    /* multi threaded implementation, each chunk owns a range of columns of y */
+    template <typename T, std::size_t Rows, std::size_t Columns>
+    [[nodiscard]] MatrixImpl<T, 1, Columns> gevm_tn_pool(const MatrixImpl<T, 1, Rows> &x, const MatrixImpl<T, Rows, Columns> &a, const execution::Policy &policy = execution::automatic) noexcept
+    {
+        MatrixImpl<T, 1, Columns> result{};
+        /* chunks of a Columns long array */
+        execution::run(policy, MatrixImpl<T, Columns, 1>::get_chunks(), [&result, &x, &a](std::size_t start, std::size_t end)
+                       { gevm_aux(result, x, a, start, end); });
+        return result;
+    }
+
+    /* single threaded (t1) implementation */
+    template <typename T, std::size_t Rows, std::size_t Columns, std::size_t Batch>
+    [[nodiscard]] constexpr MatrixImpl<T, Batch, Rows> gemv_batched_t1(const MatrixImpl<T, Rows, Columns> &a, const MatrixImpl<T, Batch, Columns> &xs) noexcept
+    {
+        MatrixImpl<T, Batch, Rows> result{};
+        gemv_batched_aux(result, a, xs, 0, Rows);
+        return result;
+    }
+
+    /* multi threaded implementation, rows of A are split into the chunks of A */
+    template <typename T, std::size_t Rows, std::size_t Columns, std::size_t Batch>
+    [[nodiscard]] MatrixImpl<T, Batch, Rows> gemv_batched_tn_pool(const MatrixImpl<T, Rows, Columns> &a, const MatrixImpl<T, Batch, Columns> &xs, const execution::Policy &policy = execution::automatic) noexcept
+    {
+        MatrixImpl<T, Batch, Rows> result{};
+        execution::run(policy, MatrixImpl<T, Rows, Columns>::get_chunks(), [&result, &a, &xs](std::size_t start, std::size_t end)
+                       { gemv_batched_aux(result, a, xs, start, end); });
+        return result;
+    }
+
+    /* Configure this to select the optimal implementation based on matrix size */
+    /* GEMV is memory bound, only large matrices are worth splitting across threads */
+    template <typename T, std::size_t Rows, std::size_t Columns>
+    [[nodiscard]] constexpr MatrixImpl<T, Rows, 1> gemv(const MatrixImpl<T, Rows, Columns> &a, const MatrixImpl<T, Columns, 1> &x, const execution::Policy &policy = execution::automatic) noexcept
+    {
+        if constexpr (Rows * Columns < 256 * 256)
+            return gemv_t1(a, x);
+        else
+            return gemv_tn_pool(a, x, policy);
+    }
+
+    template <typename T, std::size_t Rows, std::size_t Columns>
+    [[nodiscard]] constexpr MatrixImpl<T, 1, Columns> gevm(const MatrixImpl<T, 1, Rows> &x, const MatrixImpl<T, Rows, Columns> &a, const execution::Policy &policy = execution::automatic) noexcept
+    {
+        if constexpr (Rows * Columns < 256 * 256)
+            return gevm_t1(x, a);
+        else
+            return gevm_tn_pool(x, a, policy);
+    }
+
+    template <typename T, std::size_t Rows, std::size_t Columns, std::size_t Batch>
+    [[nodiscard]] constexpr MatrixImpl<T, Batch, Rows> gemv_batched(const MatrixImpl<T, Rows, Columns> &a, const MatrixImpl<T, Batch, Columns> &xs, const execution::Policy &policy = execution::automatic) noexcept
+    {
+        if constexpr (Rows * Columns * Batch < 256 * 256)
+            return gemv_batched_t1(a, xs);
+        else
+            return gemv_batched_tn_pool(a, xs, policy);
+    }
+}
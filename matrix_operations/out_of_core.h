@@ -0,0 +1,314 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <optional>
+#include <semaphore>
+#include <string>
+#include <thread>
+#include <vector>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <matrix_operations/allocator.h>
+#include <matrix_operations/execution.h>
+#include <matrix_operations/gemm.h>
+#include <matrix_operations/matrix_file.h>
+
+/* Out of core GEMM on row major matrix files (matrix_file.h format) */
+/* Operands are streamed in square tiles with pread, so only a few tiles are in memory at once. */
+/* A background thread reads the tiles of the next step while the current step is multiplied */
+/* (double buffering), and finished R tiles are written back in row major tile order. */
+namespace out_of_core
+{
+    struct Config
+    {
+        /* Upper bound for the tile buffers: 2 x (A tile + B tile) + R tile */
+        std::size_t memory_budget{256 * 1024 * 1024};
+        /* Tile edge, 0 derives it from memory_budget */
+        std::size_t tile_size{0};
+        /* Backend of the in-core tile products */
+        execution::Policy policy{};
+    };
+
+    template <typename T>
+    constexpr std::size_t tile_size_for(const Config &config) noexcept
+    {
+        if (config.tile_size != 0)
+            return config.tile_size;
+        /* 5 tiles of tile_size x tile_size */
+        auto elements = config.memory_budget / (5 * sizeof(T));
+        std::size_t tile{1};
+        while ((tile + 1) * (tile + 1) <= elements)
+        {
+            tile++;
+        }
+        return tile;
+    }
+
+    /* File descriptor that is closed when it goes out of scope */
+    class File
+    {
+    public:
+        File(const std::string &path, int flags) noexcept : fd_(::open(path.c_str(), flags, 0644)) {}
+        File(const File &) = delete;
+        ~File()
+        {
+            if (fd_ >= 0)
+                ::close(fd_);
+        }
+
+        [[nodiscard]] bool valid() const noexcept { return fd_ >= 0; }
+        [[nodiscard]] int fd() const noexcept { return fd_; }
+
+        /* path names this open file (the same device and inode, e.g. a link or another spelling) */
+        [[nodiscard]] bool is(const std::string &path) const noexcept
+        {
+            struct stat open_file{};
+            struct stat named_file{};
+            return valid() && ::fstat(fd_, &open_file) == 0 && ::stat(path.c_str(), &named_file) == 0 &&
+                   open_file.st_dev == named_file.st_dev && open_file.st_ino == named_file.st_ino;
+        }
+
+    private:
+        int fd_{-1};
+    };
+
+    /* pread / pwrite until every byte is transferred, a short transfer or EINTR is retried. */
+    /* False on an error or at the end of the file. */
+    inline bool pread_all(int fd, void *data, std::size_t bytes, off_t offset) noexcept
+    {
+        auto *bytes_in = static_cast<char *>(data);
+        while (bytes > 0)
+        {
+            auto read = ::pread(fd, bytes_in, bytes, offset);
+            if (read < 0 && errno == EINTR)
+                continue;
+            if (read <= 0)
+                return false;
+            bytes_in += read;
+            bytes -= static_cast<std::size_t>(read);
+            offset += read;
+        }
+        return true;
+    }
+
+    inline bool pwrite_all(int fd, const void *data, std::size_t bytes, off_t offset) noexcept
+    {
+        const auto *bytes_out = static_cast<const char *>(data);
+        while (bytes > 0)
+        {
+            auto written = ::pwrite(fd, bytes_out, bytes, offset);
+            if (written < 0 && errno == EINTR)
+                continue;
+            if (written <= 0)
+                return false;
+            bytes_out += written;
+            bytes -= static_cast<std::size_t>(written);
+            offset += written;
+        }
+        return true;
+    }
+
+    inline bool read_header(const File &file, matrix_io::FileHeader &header) noexcept
+    {
+        return file.valid() && pread_all(file.fd(), &header, sizeof(header), 0) &&
+               header.magic == matrix_io::file_magic && header.version == matrix_io::file_version;
+    }
+
+    /* A row major matrix file accessed in rectangular tiles */
+    template <typename T>
+    class TiledFile
+    {
+    public:
+        TiledFile(const std::string &path, int flags) noexcept : file_(path, flags)
+        {
+            std::uint64_t bytes{0};
+            valid_ = read_header(file_, header_) && header_.dtype == matrix_io::dtype_of<T>() && header_.layout == matrix_io::Layout::row_major &&
+                     matrix_io::data_size(header_.rows, header_.columns, sizeof(T), bytes) && header_.data_bytes == bytes;
+        }
+
+        /* Create a file for a rows x columns matrix. Data is filled in by write_tile */
+        TiledFile(const std::string &path, std::size_t rows, std::size_t columns) noexcept : file_(path, O_RDWR | O_CREAT | O_TRUNC)
+        {
+            header_.dtype = matrix_io::dtype_of<T>();
+            header_.rows = rows;
+            header_.columns = columns;
+            header_.data_offset = matrix_io::data_offset_for(header_.alignment);
+            header_.data_bytes = rows * columns * sizeof(T);
+            valid_ = file_.valid() && pwrite_all(file_.fd(), &header_, sizeof(header_), 0) &&
+                     ::ftruncate(file_.fd(), static_cast<off_t>(header_.data_offset + header_.data_bytes)) == 0;
+        }
+
+        [[nodiscard]] bool valid() const noexcept { return valid_; }
+        [[nodiscard]] std::size_t rows() const noexcept { return header_.rows; }
+        [[nodiscard]] std::size_t columns() const noexcept { return header_.columns; }
+        [[nodiscard]] bool is(const std::string &path) const noexcept { return file_.is(path); }
+
+        /* Read rows [row, row + height) x columns [column, column + width) into tile (leading dimension width) */
+        bool read_tile(T *tile, std::size_t row, std::size_t column, std::size_t height, std::size_t width) const noexcept
+        {
+            for (std::size_t r{0}; r < height; r++)
+            {
+                if (!pread_all(file_.fd(), tile + r * width, width * sizeof(T), offset(row + r, column)))
+                    return false;
+            }
+            return true;
+        }
+
+        bool write_tile(const T *tile, std::size_t row, std::size_t column, std::size_t height, std::size_t width) const noexcept
+        {
+            for (std::size_t r{0}; r < height; r++)
+            {
+                if (!pwrite_all(file_.fd(), tile + r * width, width * sizeof(T), offset(row + r, column)))
+                    return false;
+            }
+            return true;
+        }
+
+    private:
+        [[nodiscard]] off_t offset(std::size_t row, std::size_t column) const noexcept
+        {
+            return static_cast<off_t>(header_.data_offset + (row * header_.columns + column) * sizeof(T));
+        }
+
+        File file_;
+        matrix_io::FileHeader header_{};
+        bool valid_{false};
+    };
+
+    /* r += a . b for a height x depth tile of A and a depth x width tile of B (row major, packed) */
+    /* The GEMM of gemm.h, rows split over the policy's backend */
+    template <typename T>
+    inline void multiply_tile(T *r, const T *a, const T *b, std::size_t height, std::size_t depth, std::size_t width, const execution::Policy &policy = execution::automatic)
+    {
+        matrix::gemm(r, width, a, depth, b, width, height, width, depth, T{1}, policy);
+    }
+
+    /* R = A . B (+ C) with every operand in a file. path_c may be empty. */
+    /* Returns false if an operand can't be read, the shapes don't match, path_r is one of */
+    /* the operands (it is truncated before they are read) or an I/O call fails. */
+    template <typename T = double>
+    inline bool ab_c(const std::string &path_a, const std::string &path_b, const std::string &path_c, const std::string &path_r, const Config &config = {})
+    {
+        TiledFile<T> a{path_a, O_RDONLY};
+        TiledFile<T> b{path_b, O_RDONLY};
+        if (!a.valid() || !b.valid() || a.columns() != b.rows())
+            return false;
+
+        const bool has_c = !path_c.empty();
+        std::optional<TiledFile<T>> c{};
+        if (has_c)
+        {
+            c.emplace(path_c, O_RDONLY);
+            if (!c->valid() || c->rows() != a.rows() || c->columns() != b.columns())
+                return false;
+        }
+
+        if (a.is(path_r) || b.is(path_r) || (has_c && c->is(path_r)))
+            return false;
+        TiledFile<T> r{path_r, a.rows(), b.columns()};
+        if (!r.valid())
+            return false;
+
+        const auto tile = tile_size_for<T>(config);
+        const auto rows = a.rows();
+        const auto depth = a.columns();
+        const auto columns = b.columns();
+
+        /* One step is the product of one A tile and one B tile, steps run in (i, j, k) order. */
+        /* Every R tile has at least the step k = 0, which seeds it from C when depth is 0. */
+        struct Step
+        {
+            std::size_t i, j, k;
+        };
+        std::vector<Step> steps{};
+        for (std::size_t i{0}; i < rows; i += tile)
+        {
+            for (std::size_t j{0}; j < columns; j += tile)
+            {
+                std::size_t k{0};
+                do
+                {
+                    steps.push_back({i, j, k});
+                } while ((k += tile) < depth);
+            }
+        }
+
+        /* Double buffered A and B tiles, the loader fills one slot while the other is multiplied. */
+        /* Tiles are cache line aligned and on huge pages once they are large enough. */
+        using Tile = memory::AlignedVector<T, memory::Pages::transparent_huge>;
+        struct Slot
+        {
+            Tile a, b;
+        };
+        std::array<Slot, 2> slots{};
+        for (auto &slot : slots)
+        {
+            slot.a.resize(tile * tile);
+            slot.b.resize(tile * tile);
+        }
+        Tile r_tile(tile * tile);
+
+        std::counting_semaphore<2> free_slots{2};
+        std::counting_semaphore<2> ready_slots{0};
+        std::atomic<bool> failed{false};
+
+        std::jthread loader([&](std::stop_token token)
+                            {
+            for (std::size_t s{0}; s < steps.size() && !token.stop_requested(); s++)
+            {
+                free_slots.acquire();
+                const auto [i, j, k] = steps[s];
+                auto &slot = slots[s % 2];
+                auto height = std::min(tile, rows - i);
+                auto step_depth = std::min(tile, depth - k);
+                auto width = std::min(tile, columns - j);
+                if (!a.read_tile(slot.a.data(), i, k, height, step_depth) || !b.read_tile(slot.b.data(), k, j, step_depth, width))
+                {
+                    failed = true;
+                }
+                ready_slots.release();
+            } });
+
+        for (std::size_t s{0}; s < steps.size(); s++)
+        {
+            const auto [i, j, k] = steps[s];
+            auto height = std::min(tile, rows - i);
+            auto step_depth = std::min(tile, depth - k);
+            auto width = std::min(tile, columns - j);
+
+            /* first step of an R tile: start from C (or zero) */
+            if (k == 0)
+            {
+                std::fill(r_tile.begin(), r_tile.end(), T{0});
+                if (has_c && !c->read_tile(r_tile.data(), i, j, height, width))
+                    failed = true;
+            }
+
+            ready_slots.acquire();
+            if (!failed)
+            {
+                const auto &slot = slots[s % 2];
+                multiply_tile(r_tile.data(), slot.a.data(), slot.b.data(), height, step_depth, width, config.policy);
+            }
+            free_slots.release();
+
+            /* last step of an R tile: write it back */
+            if (k + tile >= depth && !failed && !r.write_tile(r_tile.data(), i, j, height, width))
+                failed = true;
+        }
+
+        return !failed;
+    }
+
+    /* R = A . B */
+    template <typename T = double>
+    inline bool multiply(const std::string &path_a, const std::string &path_b, const std::string &path_r, const Config &config = {})
+    {
+        return ab_c<T>(path_a, path_b, {}, path_r, config);
+    }
+}
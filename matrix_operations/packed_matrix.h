@@ -0,0 +1,184 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <matrix_operations/matrix.h>
+#include <matrix_operations/solution.h>
+#include <matrix_operations/allocator.h>
+
+/* Right hand operand packed once for repeated products A . B with the same B. */
+/* The row major B is copied into the layout the kernel streams, so the packing cost is */
+/* paid when B changes and not on every multiplication. */
+namespace matrix
+{
+    enum class Packing
+    {
+        /* Column panels of panel_width columns, each stored k by k contiguously (zero padded). */
+        /* A block of rows of A is multiplied with one panel kept in registers. */
+        panels,
+        /* B transposed, every element of R is a dot product of two contiguous rows */
+        transposed,
+    };
+
+    /* Columns per panel, a cache line of doubles (half a line of floats, two of complex<double>) */
+    inline constexpr std::size_t panel_width{8};
+    /* Rows of A sharing a pass over a panel */
+    inline constexpr std::size_t panel_rows_per_pass{4};
+
+    template <typename T, std::size_t Rows, std::size_t Columns>
+    class PackedMatrix
+    {
+    public:
+        static constexpr std::size_t number_of_panels{(Columns + panel_width - 1) / panel_width};
+
+        /* B = 0 packed in panels, so a product before the first pack() reads a full zero buffer */
+        PackedMatrix() : data_(number_of_panels * Rows * panel_width, T{0}) {}
+        explicit PackedMatrix(const MatrixImpl<T, Rows, Columns> &b, Packing packing = Packing::panels) { pack(b, packing); }
+
+        static constexpr std::size_t rows() noexcept { return Rows; }
+        static constexpr std::size_t columns() noexcept { return Columns; }
+
+        [[nodiscard]] Packing packing() const noexcept { return packing_; }
+
+        /* Repack after B changed, the buffer is reused */
+        void pack(const MatrixImpl<T, Rows, Columns> &b, Packing packing)
+        {
+            packing_ = packing;
+            if (packing_ == Packing::panels)
+            {
+                data_.assign(number_of_panels * Rows * panel_width, T{0});
+                for (std::size_t k = 0; k < Rows; k++)
+                {
+                    for (std::size_t j = 0; j < Columns; j++)
+                    {
+                        data_[(j / panel_width * Rows + k) * panel_width + j % panel_width] = b.data()[k][j];
+                    }
+                }
+            }
+            else
+            {
+                data_.resize(Rows * Columns);
+                for (std::size_t k = 0; k < Rows; k++)
+                {
+                    for (std::size_t j = 0; j < Columns; j++)
+                    {
+                        data_[j * Rows + k] = b.data()[k][j];
+                    }
+                }
+            }
+        }
+        void pack(const MatrixImpl<T, Rows, Columns> &b) { pack(b, packing_); }
+
+        /* Rows x panel_width block of panel p */
+        [[nodiscard]] const T *panel(std::size_t p) const noexcept { return data_.data() + p * Rows * panel_width; }
+        /* Column j of B */
+        [[nodiscard]] const T *column(std::size_t j) const noexcept { return data_.data() + j * Rows; }
+
+    private:
+        Packing packing_{Packing::panels};
+        memory::AlignedVector<T, memory::Pages::transparent_huge> data_{};
+    };
+
+    namespace detail
+    {
+        /* R[i, panel p] = A[i .. i + RowsPerPass] . panel p, the block of R is accumulated in registers */
+        template <std::size_t RowsPerPass, typename T, std::size_t Rows, std::size_t Columns, std::size_t OtherColumns>
+        constexpr void panel_block(MatrixImpl<T, Rows, OtherColumns> &result, const MatrixImpl<T, Rows, Columns> &a, const PackedMatrix<T, Columns, OtherColumns> &b, std::size_t i, std::size_t p) noexcept
+        {
+            const auto *panel = b.panel(p);
+            T sum[RowsPerPass][panel_width]{};
+            for (std::size_t k = 0; k < Columns; k++)
+            {
+                const auto *b_k = panel + k * panel_width;
+                for (std::size_t r = 0; r < RowsPerPass; r++)
+                {
+                    auto a_ik = a.data()[i + r][k];
+                    for (std::size_t jj = 0; jj < panel_width; jj++)
+                    {
+                        sum[r][jj] += a_ik * b_k[jj];
+                    }
+                }
+            }
+            const auto width = std::min(panel_width, OtherColumns - p * panel_width);
+            for (std::size_t r = 0; r < RowsPerPass; r++)
+            {
+                std::copy(sum[r], sum[r] + width, result.data()[i + r].begin() + p * panel_width);
+            }
+        }
+    }
+
+    /* R = A . B for rows start to end, R is overwritten */
+    template <typename T, std::size_t Rows, std::size_t Columns, std::size_t OtherColumns>
+    constexpr void packed_multiplication_aux(MatrixImpl<T, Rows, OtherColumns> &result, const MatrixImpl<T, Rows, Columns> &a, const PackedMatrix<T, Columns, OtherColumns> &b, std::size_t start, std::size_t end) noexcept
+    {
+        if (b.packing() == Packing::panels)
+        {
+            std::size_t i{start};
+            for (; i + panel_rows_per_pass <= end; i += panel_rows_per_pass)
+            {
+                for (std::size_t p = 0; p < b.number_of_panels; p++)
+                {
+                    detail::panel_block<panel_rows_per_pass>(result, a, b, i, p);
+                }
+            }
+            /* remaining rows of the chunk */
+            for (; i < end; i++)
+            {
+                for (std::size_t p = 0; p < b.number_of_panels; p++)
+                {
+                    detail::panel_block<1>(result, a, b, i, p);
+                }
+            }
+            return;
+        }
+
+        for (std::size_t i{start}; i < end; i++)
+        {
+            const auto &a_i = a.data()[i];
+            for (std::size_t j = 0; j < OtherColumns; j++)
+            {
+                const auto *b_j = b.column(j);
+                T sum{0};
+                for (std::size_t k = 0; k < Columns; k++)
+                {
+                    sum += a_i[k] * b_j[k];
+                }
+                result.data()[i][j] = sum;
+            }
+        }
+    }
+
+    /* The chunks run on the policy's backend (execution.h) */
+    template <typename T, std::size_t Rows, std::size_t Columns, std::size_t OtherColumns>
+    inline MatrixImpl<T, Rows, OtherColumns> multiplication(const MatrixImpl<T, Rows, Columns> &a, const PackedMatrix<T, Columns, OtherColumns> &b, const execution::Policy &policy = execution::automatic)
+    {
+        MatrixImpl<T, Rows, OtherColumns> result{};
+        execution::run(policy, MatrixImpl<T, Rows, Columns>::get_chunks(), [&result, &a, &b](std::size_t start, std::size_t end)
+                       { packed_multiplication_aux(result, a, b, start, end); });
+        return result;
+    }
+
+    template <typename T, std::size_t Rows, std::size_t Columns, std::size_t OtherColumns>
+    inline MatrixImpl<T, Rows, OtherColumns> operator*(const MatrixImpl<T, Rows, Columns> &a, const PackedMatrix<T, Columns, OtherColumns> &b)
+    {
+        return multiplication(a, b, execution::automatic);
+    }
+
+    /* R = A . B + C, C is added to each block of rows while it is in cache */
+    template <typename T, std::size_t Rows, std::size_t Columns, std::size_t OtherColumns>
+    inline MatrixImpl<T, Rows, OtherColumns> ab_c(const MatrixImpl<T, Rows, Columns> &a, const PackedMatrix<T, Columns, OtherColumns> &b, const MatrixImpl<T, Rows, OtherColumns> &c, const execution::Policy &policy = execution::automatic)
+    {
+        MatrixImpl<T, Rows, OtherColumns> result{};
+        execution::run(policy, MatrixImpl<T, Rows, Columns>::get_chunks(), [&result, &a, &b, &c](std::size_t start, std::size_t end)
+                       {
+            packed_multiplication_aux(result, a, b, start, end);
+            for (std::size_t i{start}; i < end; i++)
+            {
+                for (std::size_t j{0}; j < OtherColumns; j++)
+                {
+                    result.data()[i][j] += c.data()[i][j];
+                }
+            } });
+        return result;
+    }
+}
@@ -0,0 +1,165 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <vector>
+#include <matrix_operations/allocator.h>
+
+/* Per thread bump allocator for the temporaries of a kernel. */
+/* Memory is taken from large cache line aligned blocks and given back in LIFO order by */
+/* rewinding to a checkpoint (Scope), the blocks stay with the thread. Once the blocks */
+/* cover the largest working set, repeated kernels don't call malloc or free at all. */
+namespace memory
+{
+    /* Process wide counters of all arenas, to check the steady state in production */
+    struct ArenaCounters
+    {
+        /* blocks taken from / returned to the system allocator */
+        std::atomic<std::uint64_t> system_allocations{0};
+        std::atomic<std::uint64_t> system_frees{0};
+        /* bytes held in blocks right now */
+        std::atomic<std::uint64_t> bytes_reserved{0};
+        /* bump allocations served by the arenas */
+        std::atomic<std::uint64_t> allocations{0};
+    };
+
+    inline ArenaCounters &arena_counters() noexcept
+    {
+        static ArenaCounters counters{};
+        return counters;
+    }
+
+    class ScratchArena
+    {
+    public:
+        /* big enough for huge pages (allocator.h) */
+        static constexpr std::size_t default_block_size{4 * 1024 * 1024};
+
+        struct Checkpoint
+        {
+            std::size_t block{0};
+            std::size_t offset{0};
+        };
+
+        /* Rewinds the arena to where it was when the scope was opened */
+        class Scope
+        {
+        public:
+            explicit Scope(ScratchArena &arena) noexcept : arena_(arena), checkpoint_(arena.checkpoint()) {}
+            Scope(const Scope &) = delete;
+            ~Scope() { arena_.rewind(checkpoint_); }
+
+        private:
+            ScratchArena &arena_;
+            Checkpoint checkpoint_;
+        };
+
+        explicit ScratchArena(std::size_t block_size = default_block_size) noexcept : block_size_(block_size) {}
+        ScratchArena(const ScratchArena &) = delete;
+        ~ScratchArena()
+        {
+            auto &counters = arena_counters();
+            for (const auto &block : blocks_)
+            {
+                deallocate(block.data, block.size, Pages::transparent_huge);
+                counters.system_frees.fetch_add(1, std::memory_order_relaxed);
+                counters.bytes_reserved.fetch_sub(block.size, std::memory_order_relaxed);
+            }
+        }
+
+        /* The arena of the calling thread */
+        static ScratchArena &local()
+        {
+            thread_local ScratchArena arena{};
+            return arena;
+        }
+
+        /* Uninitialised, cache line aligned storage for n objects of T, valid until the enclosing scope ends */
+        template <typename T>
+        [[nodiscard]] T *allocate(std::size_t n)
+        {
+            static_assert(alignof(T) <= cache_line_size && std::is_trivially_destructible_v<T>);
+            const auto bytes = detail::round_up(n * sizeof(T), cache_line_size);
+            arena_counters().allocations.fetch_add(1, std::memory_order_relaxed);
+
+            /* next block with room, blocks after the current one are reused after a rewind */
+            while (current_ < blocks_.size() && offset_ + bytes > blocks_[current_].size)
+            {
+                current_++;
+                offset_ = 0;
+            }
+            if (current_ == blocks_.size())
+            {
+                grow(bytes);
+            }
+
+            auto *ptr = blocks_[current_].data + offset_;
+            offset_ += bytes;
+            high_water_ = std::max(high_water_, used());
+            return static_cast<T *>(static_cast<void *>(ptr));
+        }
+
+        [[nodiscard]] Checkpoint checkpoint() const noexcept { return {current_, offset_}; }
+
+        void rewind(const Checkpoint &checkpoint) noexcept
+        {
+            current_ = checkpoint.block;
+            offset_ = checkpoint.offset;
+        }
+
+        /* bytes held by the arena's blocks */
+        [[nodiscard]] std::size_t reserved() const noexcept
+        {
+            std::size_t bytes{0};
+            for (const auto &block : blocks_)
+            {
+                bytes += block.size;
+            }
+            return bytes;
+        }
+        /* bytes handed out (blocks before the current one count as full) */
+        [[nodiscard]] std::size_t used() const noexcept
+        {
+            std::size_t bytes{offset_};
+            for (std::size_t i = 0; i < current_ && i < blocks_.size(); i++)
+            {
+                bytes += blocks_[i].size;
+            }
+            return bytes;
+        }
+        [[nodiscard]] std::size_t high_water() const noexcept { return high_water_; }
+        [[nodiscard]] std::size_t blocks() const noexcept { return blocks_.size(); }
+
+    private:
+        struct Block
+        {
+            std::byte *data{nullptr};
+            std::size_t size{0};
+        };
+
+        void grow(std::size_t bytes)
+        {
+            const auto size = std::max(block_size_, bytes);
+            auto *data = static_cast<std::byte *>(memory::allocate(size, Pages::transparent_huge));
+            if (!data)
+                throw std::bad_alloc{};
+            blocks_.push_back({data, size});
+            current_ = blocks_.size() - 1;
+            offset_ = 0;
+
+            auto &counters = arena_counters();
+            counters.system_allocations.fetch_add(1, std::memory_order_relaxed);
+            counters.bytes_reserved.fetch_add(size, std::memory_order_relaxed);
+        }
+
+        std::size_t block_size_;
+        std::vector<Block> blocks_{};
+        std::size_t current_{0};
+        std::size_t offset_{0};
+        std::size_t high_water_{0};
+    };
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <type_traits>
+#include <matrix_operations/matrix.h>
+
+/* Matrix products over a semiring, R[i][j] = add over k of multiply(A[i][k], B[k][j]). */
+/* A semiring is a policy type with value_type, add, multiply, zero (identity of add, */
+/* annihilates multiply) and one (identity of multiply). (+, *) is the usual product, */
+/* (min, +) gives shortest paths, (max, +) longest / critical paths and (or, and) reachability. */
+/* The loops are the i-k-j order of MatrixImpl::multiplication_t_aux and the chunks run on */
+/* the policy's backend. Rows of B are skipped for A[i][k] == zero (missing edges). */
+/* (min, +) and (max, +) mark a missing edge with the largest / lowest finite value instead */
+/* of +-infinity, which -ffast-math assumes never occurs; multiply keeps the sentinel when */
+/* either operand is the sentinel (zero()), other path lengths must stay inside the range of T. */
+namespace matrix
+{
+    template <typename T>
+    struct PlusTimes
+    {
+        using value_type = T;
+        static constexpr T zero() noexcept { return T{0}; }
+        static constexpr T one() noexcept { return T{1}; }
+        static constexpr T add(T a, T b) noexcept { return a + b; }
+        static constexpr T multiply(T a, T b) noexcept { return a * b; }
+    };
+
+    template <typename T>
+    struct MinPlus
+    {
+        using value_type = T;
+        /* no edge */
+        static constexpr T zero() noexcept { return std::numeric_limits<T>::max(); }
+        static constexpr T one() noexcept { return T{0}; }
+        static constexpr T add(T a, T b) noexcept { return std::min(a, b); }
+        static constexpr T multiply(T a, T b) noexcept { return a == zero() || b == zero() ? zero() : a + b; }
+    };
+
+    template <typename T>
+    struct MaxPlus
+    {
+        using value_type = T;
+        /* no edge */
+        static constexpr T zero() noexcept { return std::numeric_limits<T>::lowest(); }
+        static constexpr T one() noexcept { return T{0}; }
+        static constexpr T add(T a, T b) noexcept { return std::max(a, b); }
+        static constexpr T multiply(T a, T b) noexcept { return a == zero() || b == zero() ? zero() : a + b; }
+    };
+
+    template <typename T = bool>
+    struct OrAnd
+    {
+        using value_type = T;
+        static constexpr T zero() noexcept { return T{false}; }
+        static constexpr T one() noexcept { return T{true}; }
+        static constexpr T add(T a, T b) noexcept { return a || b; }
+        static constexpr T multiply(T a, T b) noexcept { return a && b; }
+    };
+
+    /* r[j] = add(r[j], multiply(a_ik, b_k[j])) for one row of R, the innermost loop. */
+    /* min / max / or are branch free here, the compiler vectorises the loop for every policy */
+    /* above; specialise the kernel for semirings where it does not. */
+    template <typename S>
+    struct SemiringKernel
+    {
+        using T = typename S::value_type;
+
+        static void row(T *r, T a_ik, const T *b_k, std::size_t n) noexcept
+        {
+            for (std::size_t j = 0; j < n; j++)
+            {
+                r[j] = S::add(r[j], S::multiply(a_ik, b_k[j]));
+            }
+        }
+    };
+
+    /* R = A . B over S for rows start to end, R is overwritten */
+    template <typename S, typename T, std::size_t Rows, std::size_t Columns, std::size_t OtherColumns>
+    inline void semiring_multiplication_aux(MatrixImpl<T, Rows, OtherColumns> &result, const MatrixImpl<T, Rows, Columns> &a, const MatrixImpl<T, Columns, OtherColumns> &b, std::size_t start, std::size_t end) noexcept
+    {
+        static_assert(std::is_same_v<T, typename S::value_type>);
+        for (std::size_t i{start}; i < end; i++)
+        {
+            auto &r_i = result.data()[i];
+            r_i.fill(S::zero());
+            for (std::size_t k{0}; k < Columns; k++)
+            {
+                const auto a_ik = a.data()[i][k];
+                if (a_ik == S::zero())
+                    continue;
+                SemiringKernel<S>::row(r_i.data(), a_ik, b.data()[k].data(), OtherColumns);
+            }
+        }
+    }
+
+    /* R = A . B over S, R must not be A or B */
+    template <typename S, typename T, std::size_t Rows, std::size_t Columns, std::size_t OtherColumns>
+    inline void multiply(MatrixImpl<T, Rows, OtherColumns> &result, const MatrixImpl<T, Rows, Columns> &a, const MatrixImpl<T, Columns, OtherColumns> &b, const execution::Policy &policy = execution::automatic)
+    {
+        execution::run(policy, MatrixImpl<T, Rows, Columns>::get_chunks(), [&result, &a, &b](std::size_t start, std::size_t end)
+                       { semiring_multiplication_aux<S>(result, a, b, start, end); });
+    }
+
+    template <typename S, typename T, std::size_t Rows, std::size_t Columns, std::size_t OtherColumns>
+    [[nodiscard]] inline MatrixImpl<T, Rows, OtherColumns> multiply(const MatrixImpl<T, Rows, Columns> &a, const MatrixImpl<T, Columns, OtherColumns> &b, const execution::Policy &policy = execution::automatic)
+    {
+        MatrixImpl<T, Rows, OtherColumns> result{};
+        multiply<S>(result, a, b, policy);
+        return result;
+    }
+
+    /* The identity of the semiring product, one on the diagonal and zero elsewhere */
+    template <typename S, std::size_t N>
+    [[nodiscard]] constexpr MatrixImpl<typename S::value_type, N, N> semiring_identity() noexcept
+    {
+        MatrixImpl<typename S::value_type, N, N> result{};
+        for (std::size_t i = 0; i < N; i++)
+        {
+            result.data()[i].fill(S::zero());
+            result.data()[i][i] = S::one();
+        }
+        return result;
+    }
+}
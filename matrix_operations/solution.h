@@ -49,25 +49,39 @@ namespace matrix
         return result;
     }
 
-    /* multi threaded (tn) implementation */
+    /* The chunks run on the policy's backend (execution.h) */
     template <typename T, std::size_t Rows, std::size_t Columns, std::size_t OtherColumns>
-    inline /*constexpr*/ MatrixImpl<T, Rows, OtherColumns> ab_c_optimised_tn(MatrixImpl<T, Rows, Columns> &a, MatrixImpl<T, Columns, OtherColumns> &b, MatrixImpl<T, Rows, OtherColumns> &c)
+    inline MatrixImpl<T, Rows, OtherColumns> ab_c(MatrixImpl<T, Rows, Columns> &a, MatrixImpl<T, Columns, OtherColumns> &b, MatrixImpl<T, Rows, OtherColumns> &c, const execution::Policy &policy)
     {
         MatrixImpl<T, Rows, OtherColumns> result{};
-        std::vector<std::thread> threads{};
-        for (auto &chunk : MatrixImpl<T, Rows, Columns>::get_chunks())
-        {
-            /* thread creation is costly, use thread pools for better performance */
-            threads.emplace_back([&result, &a, &b, &c, &chunk]()
-                                 { ab_c_optimised_aux(result, a, b, c, chunk.first, chunk.second); });
-        }
+        execution::run(policy, MatrixImpl<T, Rows, Columns>::get_chunks(), [&result, &a, &b, &c](std::size_t start, std::size_t end)
+                       { ab_c_optimised_aux(result, a, b, c, start, end); });
+        return result;
+    }
 
-        for (auto &thread : threads)
-        {
-            thread.join();
-        }
+    /* Cancellable variant, stops between row blocks once the token is stopped or the deadline passed. */
+    /* result is only valid if the outcome is ok() */
+    template <typename T, std::size_t Rows, std::size_t Columns, std::size_t OtherColumns>
+    [[nodiscard]] inline execution::Outcome ab_c(MatrixImpl<T, Rows, OtherColumns> &result, MatrixImpl<T, Rows, Columns> &a, MatrixImpl<T, Columns, OtherColumns> &b, MatrixImpl<T, Rows, OtherColumns> &c, const execution::Cancellation &cancellation, const execution::Policy &policy = execution::automatic)
+    {
+        /* ab_c_optimised_aux accumulates, each block zeroes its rows first */
+        return execution::run(
+            policy, MatrixImpl<T, Rows, Columns>::get_chunks(), [&result, &a, &b, &c](std::size_t start, std::size_t end)
+            {
+                for (std::size_t i{start}; i < end; i++)
+                {
+                    result.data()[i].fill(T{0});
+                }
+                ab_c_optimised_aux(result, a, b, c, start, end); },
+            cancellation);
+    }
 
-        return result;
+    /* multi threaded (tn) implementation */
+    /* Threads are only created within the global thread budget, nested calls are serial (execution.h) */
+    template <typename T, std::size_t Rows, std::size_t Columns, std::size_t OtherColumns>
+    inline /*constexpr*/ MatrixImpl<T, Rows, OtherColumns> ab_c_optimised_tn(MatrixImpl<T, Rows, Columns> &a, MatrixImpl<T, Columns, OtherColumns> &b, MatrixImpl<T, Rows, OtherColumns> &c)
+    {
+        return ab_c(a, b, c, execution::threads);
     }
 
     template <typename T, std::size_t Rows, std::size_t Columns, std::size_t OtherColumns>
@@ -77,8 +91,9 @@ namespace matrix
         std::size_t i{0};
         std::size_t j{0};
         std::size_t k{0};
-        omp_set_num_threads(MatrixImpl<T, Rows, Columns>::number_of_worker_threads());
-#pragma omp parallel for private(i, j, k)
+        /* serial when nested or when the thread budget is used up */
+        execution::Team team{execution::default_threads()};
+#pragma omp parallel for private(i, j, k) num_threads(static_cast<int>(team.threads())) if (team.threads() > 1)
         for (i = 0; i < a.rows(); i++)
         {
             /* For each column in A (row in B) */
@@ -107,9 +122,8 @@ namespace matrix
     {
         if constexpr (Rows * Columns * OtherColumns < 8 * 8 * 8)
             return ab_c_optimised(a, b, c);
-        else if constexpr (Rows * Columns * OtherColumns < 128 * 128 * 128)
-            return ab_c_omp(a, b, c);
+        /* the process wide default backend, one thread team for every operation */
         else
-            return ab_c_optimised_tn(a, b, c);
+            return ab_c(a, b, c, execution::automatic);
     }
 }
@@ -1,9 +1,12 @@
 #pragma once
 
 #include <vector>
+#include <algorithm>
+#include <functional>
 #include <array>
 #include <iostream>
 #include <matrix_operations/matrix.h>
+#include <matrix_operations/scratch_arena.h>
 
 inline std::ostream &operator<<(std::ostream &os, const std::vector<std::vector<double>> &matrix)
 {
@@ -52,103 +55,182 @@ namespace strassens
         return r;
     }
 
-    inline std::vector<std::vector<double>> mat_mul(const std::vector<std::vector<double>> &a, const std::vector<std::vector<double>> &b)
+    inline bool is_power_of_two(std::size_t n)
     {
-        auto N = a.size();
+        // Check if N is non-negative and has only one bit set
+        return n > 0 && (n & (n - 1)) == 0;
+    }
 
-        std::vector<std::vector<double>> r(N, std::vector<double>(N, 0));
-        // base case
-        if (N == 1)
+    /* Strassen on row major n x n blocks addressed with a leading dimension. */
+    /* Quadrants are views into the operands, the sums and the 7 products are taken from */
+    /* the thread's scratch arena, so repeated calls don't allocate once the arenas are warm. */
+    namespace detail
+    {
+        /* Below this the classic kernel is faster than another level of recursion */
+        inline constexpr std::size_t leaf_size{32};
+
+        /* r = a op b */
+        template <typename Op>
+        inline void combine(double *r, std::size_t ldr, const double *a, std::size_t lda, const double *b, std::size_t ldb, std::size_t n, Op op)
         {
-            r[0][0] = a[0][0] * b[0][0];
-            return r;
+            for (std::size_t i = 0; i < n; i++)
+            {
+                for (std::size_t j = 0; j < n; j++)
+                {
+                    r[i * ldr + j] = op(a[i * lda + j], b[i * ldb + j]);
+                }
+            }
         }
 
-        auto mid = N / 2;
-
-        /* initilize vectors to size with value 0 */
-        std::vector<std::vector<double>> a11(mid, std::vector<double>(mid, 0));
-        std::vector<std::vector<double>> a12(mid, std::vector<double>(mid, 0));
-        std::vector<std::vector<double>> a21(mid, std::vector<double>(mid, 0));
-        std::vector<std::vector<double>> a22(mid, std::vector<double>(mid, 0));
-
-        std::vector<std::vector<double>> b11(mid, std::vector<double>(mid, 0));
-        std::vector<std::vector<double>> b12(mid, std::vector<double>(mid, 0));
-        std::vector<std::vector<double>> b21(mid, std::vector<double>(mid, 0));
-        std::vector<std::vector<double>> b22(mid, std::vector<double>(mid, 0));
-
-        /* Fill A & B */
-        for (std::size_t i = 0; i < mid; i++)
+        /* r = a . b, same i-k-j order as MatrixImpl::multiplication_t_aux */
+        inline void multiply_leaf(double *r, std::size_t ldr, const double *a, std::size_t lda, const double *b, std::size_t ldb, std::size_t n)
         {
-            for (std::size_t j = 0; j < mid; j++)
+            for (std::size_t i = 0; i < n; i++)
             {
-                /* each block is size of mid, so mid + i & mid + j */
-                a11[i][j] = a[i][j];
-                a12[i][j] = a[i][mid + j];
-                a21[i][j] = a[mid + i][j];
-                a22[i][j] = a[mid + i][mid + j];
-
-                b11[i][j] = b[i][j];
-                b12[i][j] = b[i][mid + j];
-                b21[i][j] = b[mid + i][j];
-                b22[i][j] = b[mid + i][mid + j];
+                std::fill(r + i * ldr, r + i * ldr + n, 0.0);
+                for (std::size_t k = 0; k < n; k++)
+                {
+                    auto a_ik = a[i * lda + k];
+                    for (std::size_t j = 0; j < n; j++)
+                    {
+                        r[i * ldr + j] += a_ik * b[k * ldb + j];
+                    }
+                }
             }
         }
 
-        // P1 = A11 * (B12 - B22)
-        // P2 = (A11 + A12) * B22
-        // P3 = (A21 + A22) * B11
-        // P4 = A22 * (B21 - B11)
-        // P5 = (A11 + A22) * (B11 + B22)
-        // P6 = (A12 - A22) * (B21 + B22)
-        // P7 = (A11 - A21) * (B11 + B12)
-
-        auto p1 = mat_mul(a11, mat_sub(b12, b22));
-        auto p2 = mat_mul(mat_add(a11, a12), b22);
-        auto p3 = mat_mul(mat_add(a21, a22), b11);
-        auto p4 = mat_mul(a22, mat_sub(b21, b11));
-        auto p5 = mat_mul(mat_add(a11, a22), mat_add(b11, b22));
-        auto p6 = mat_mul(mat_sub(a12, a22), mat_add(b21, b22));
-        auto p7 = mat_mul(mat_sub(a11, a21), mat_add(b11, b12));
-
-        // C11 = P5 + P4 - P2 + P6
-        // C12 = P1 + P2
-        // C21 = P3 + P4
-        // C22 = P5 + P1 - P3 - P7
-
-        auto c11 = mat_sub(mat_add(mat_add(p5, p4), p6), p2);
-        auto c12 = mat_add(p1, p2);
-        auto c21 = mat_add(p3, p4);
-        auto c22 = mat_sub(mat_sub(mat_add(p5, p1), p3), p7);
-
-        for (std::size_t i = 0; i < mid; i++)
+        inline void multiply(double *r, std::size_t ldr, const double *a, std::size_t lda, const double *b, std::size_t ldb, std::size_t n, const execution::Policy &policy)
         {
-            for (std::size_t j = 0; j < mid; j++)
+            if (n <= leaf_size || n % 2 != 0)
             {
-                r[i][j] = c11[i][j];
-                r[i][mid + j] = c12[i][j];
-                r[mid + i][j] = c21[i][j];
-                r[mid + i][mid + j] = c22[i][j];
+                multiply_leaf(r, ldr, a, lda, b, ldb, n);
+                return;
+            }
+
+            const auto mid = n / 2;
+            const auto *a11 = a, *a12 = a + mid, *a21 = a + mid * lda, *a22 = a + mid * lda + mid;
+            const auto *b11 = b, *b12 = b + mid, *b21 = b + mid * ldb, *b22 = b + mid * ldb + mid;
+
+            auto &arena = memory::ScratchArena::local();
+            memory::ScratchArena::Scope scope{arena};
+            std::array<double *, 7> p{};
+            for (auto &product : p)
+            {
+                product = arena.allocate<double>(mid * mid);
+            }
+
+            /* runs on any thread, the operand sums come from that thread's arena */
+            auto product = [&](std::size_t i)
+            {
+                auto &local = memory::ScratchArena::local();
+                memory::ScratchArena::Scope product_scope{local};
+                auto *x = local.allocate<double>(mid * mid);
+                auto *y = local.allocate<double>(mid * mid);
+                const auto plus = std::plus<double>{};
+                const auto minus = std::minus<double>{};
+                switch (i)
+                {
+                case 0: // P1 = A11 * (B12 - B22)
+                    combine(y, mid, b12, ldb, b22, ldb, mid, minus);
+                    multiply(p[0], mid, a11, lda, y, mid, mid, execution::serial);
+                    break;
+                case 1: // P2 = (A11 + A12) * B22
+                    combine(x, mid, a11, lda, a12, lda, mid, plus);
+                    multiply(p[1], mid, x, mid, b22, ldb, mid, execution::serial);
+                    break;
+                case 2: // P3 = (A21 + A22) * B11
+                    combine(x, mid, a21, lda, a22, lda, mid, plus);
+                    multiply(p[2], mid, x, mid, b11, ldb, mid, execution::serial);
+                    break;
+                case 3: // P4 = A22 * (B21 - B11)
+                    combine(y, mid, b21, ldb, b11, ldb, mid, minus);
+                    multiply(p[3], mid, a22, lda, y, mid, mid, execution::serial);
+                    break;
+                case 4: // P5 = (A11 + A22) * (B11 + B22)
+                    combine(x, mid, a11, lda, a22, lda, mid, plus);
+                    combine(y, mid, b11, ldb, b22, ldb, mid, plus);
+                    multiply(p[4], mid, x, mid, y, mid, mid, execution::serial);
+                    break;
+                case 5: // P6 = (A12 - A22) * (B21 + B22)
+                    combine(x, mid, a12, lda, a22, lda, mid, minus);
+                    combine(y, mid, b21, ldb, b22, ldb, mid, plus);
+                    multiply(p[5], mid, x, mid, y, mid, mid, execution::serial);
+                    break;
+                default: // P7 = (A11 - A21) * (B11 + B12)
+                    combine(x, mid, a11, lda, a21, lda, mid, minus);
+                    combine(y, mid, b11, ldb, b12, ldb, mid, plus);
+                    multiply(p[6], mid, x, mid, y, mid, mid, execution::serial);
+                    break;
+                }
+            };
+            static const std::vector<std::pair<std::size_t, std::size_t>> chunks{{0, 1}, {1, 2}, {2, 3}, {3, 4}, {4, 5}, {5, 6}, {6, 7}};
+            execution::run(policy, chunks, [&product](std::size_t start, std::size_t end)
+                           {
+                for (auto i = start; i < end; i++)
+                {
+                    product(i);
+                } });
+
+            // C11 = P5 + P4 - P2 + P6
+            // C12 = P1 + P2
+            // C21 = P3 + P4
+            // C22 = P5 + P1 - P3 - P7
+            for (std::size_t i = 0; i < mid; i++)
+            {
+                for (std::size_t j = 0; j < mid; j++)
+                {
+                    const auto k = i * mid + j;
+                    r[i * ldr + j] = p[4][k] + p[3][k] - p[1][k] + p[5][k];
+                    r[i * ldr + mid + j] = p[0][k] + p[1][k];
+                    r[(mid + i) * ldr + j] = p[2][k] + p[3][k];
+                    r[(mid + i) * ldr + mid + j] = p[4][k] + p[0][k] - p[2][k] - p[6][k];
+                }
             }
         }
+    }
 
-        return r;
+    /* R = A . B for n x n row major matrices, the 7 products of the top level run on the policy's backend */
+    inline void multiply(double *r, const double *a, const double *b, std::size_t n, const execution::Policy &policy = execution::serial)
+    {
+        detail::multiply(r, n, a, n, b, n, n, policy);
     }
 
-    inline bool is_power_of_two(std::size_t n)
+    /* R = A . B without any heap allocation once the scratch arenas are warm */
+    template <std::size_t N>
+    inline void multiply(matrix::Matrix<N, N> &r, const matrix::Matrix<N, N> &a, const matrix::Matrix<N, N> &b, const execution::Policy &policy = execution::serial)
     {
-        // Check if N is non-negative and has only one bit set
-        return n > 0 && (n & (n - 1)) == 0;
+        multiply(r.data()[0].data(), a.data()[0].data(), b.data()[0].data(), N, policy);
     }
 
-    inline std::vector<std::vector<double>> strassens_mult(const std::vector<std::vector<double>> &a, const std::vector<std::vector<double>> &b)
+    /* The 7 products of the top level run on the policy's backend */
+    inline std::vector<std::vector<double>> strassens_mult(const std::vector<std::vector<double>> &a, const std::vector<std::vector<double>> &b, const execution::Policy &policy)
     {
         // validate preconditions
         if ((a.size() == a[0].size()) && (a.size() == b.size()) && (b.size() == b[0].size()))
         {
             if (is_power_of_two(a.size()))
             {
-                return mat_mul(a, b);
+                /* flat copies of the operands in the arena */
+                const auto n = a.size();
+                auto &arena = memory::ScratchArena::local();
+                memory::ScratchArena::Scope scope{arena};
+                auto *a_flat = arena.allocate<double>(n * n);
+                auto *b_flat = arena.allocate<double>(n * n);
+                auto *r_flat = arena.allocate<double>(n * n);
+                for (std::size_t i = 0; i < n; i++)
+                {
+                    std::copy(a[i].begin(), a[i].end(), a_flat + i * n);
+                    std::copy(b[i].begin(), b[i].end(), b_flat + i * n);
+                }
+
+                multiply(r_flat, a_flat, b_flat, n, policy);
+
+                std::vector<std::vector<double>> r(n);
+                for (std::size_t i = 0; i < n; i++)
+                {
+                    r[i].assign(r_flat + i * n, r_flat + (i + 1) * n);
+                }
+                return r;
             }
         }
 
@@ -156,6 +238,22 @@ namespace strassens
         return {};
     }
 
+    inline std::vector<std::vector<double>> strassens_mult(const std::vector<std::vector<double>> &a, const std::vector<std::vector<double>> &b)
+    {
+        return strassens_mult(a, b, execution::serial);
+    }
+
+    /* Kept for existing callers, the recursion runs on strassens::multiply like strassens_mult */
+    inline std::vector<std::vector<double>> mat_mul(const std::vector<std::vector<double>> &a, const std::vector<std::vector<double>> &b, const execution::Policy &policy)
+    {
+        return strassens_mult(a, b, policy);
+    }
+
+    inline std::vector<std::vector<double>> mat_mul(const std::vector<std::vector<double>> &a, const std::vector<std::vector<double>> &b)
+    {
+        return strassens_mult(a, b, execution::serial);
+    }
+
     template <typename T>
     inline std::vector<std::vector<double>> array_to_vec_matrix(const T &mat)
     {
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <vector>
+#include <matrix_operations/matrix.h>
+#include <matrix_operations/allocator.h>
+
+/* Gram matrix X^T . X and covariance of the last `window` rows of a stream. */
+/* A row entering the window is a rank 1 update G += x . x^T, a row leaving it G -= x . x^T, */
+/* so a tick costs O(d^2) instead of the O(n d^2) product over the whole window. */
+/* Only the upper triangle of G is updated, the snapshots mirror it. */
+namespace matrix
+{
+    template <typename T, std::size_t D>
+    class StreamingGram
+    {
+    public:
+        using Row = std::array<T, D>;
+
+        explicit StreamingGram(std::size_t window) : window_(std::max<std::size_t>(window, 1))
+        {
+            rows_.resize(window_ * D);
+            gram_.resize(D * D);
+        }
+
+        [[nodiscard]] std::size_t window() const noexcept { return window_; }
+        /* rows in the window */
+        [[nodiscard]] std::size_t size() const noexcept { return size_; }
+
+        /* Add a row, the oldest row leaves once the window is full */
+        void push(const Row &row) { push(row.data(), 1); }
+
+        /* Micro-batch of count rows, row major. Entering and leaving rows are applied */
+        /* in a single pass over G (rank k update). */
+        void push(const T *rows, std::size_t count)
+        {
+            if (count >= window_)
+            {
+                /* only the newest rows stay */
+                rows += (count - window_) * D;
+                std::copy(rows, rows + window_ * D, rows_.begin());
+                head_ = 0;
+                size_ = window_;
+                recompute();
+                return;
+            }
+
+            entering_.clear();
+            leaving_.clear();
+            for (std::size_t r = 0; r < count; r++)
+            {
+                entering_.push_back(rows + r * D);
+            }
+            const auto evicted = size_ + count > window_ ? size_ + count - window_ : 0;
+            for (std::size_t r = 0; r < evicted; r++)
+            {
+                leaving_.push_back(slot((head_ + r) % window_));
+            }
+            rank_update();
+
+            /* the new rows take the slots of the evicted ones and the free slots after the newest */
+            for (std::size_t r = 0; r < count; r++)
+            {
+                std::copy(rows + r * D, rows + (r + 1) * D, slot((head_ + size_ + r) % window_));
+            }
+            head_ = (head_ + evicted) % window_;
+            size_ += count - evicted;
+        }
+
+        /* Rebuild G and the column sums from the rows in the window, removes accumulated rounding errors */
+        void recompute()
+        {
+            std::fill(gram_.begin(), gram_.end(), T{0});
+            sum_.fill(T{0});
+            entering_.clear();
+            leaving_.clear();
+            for (std::size_t r = 0; r < size_; r++)
+            {
+                entering_.push_back(slot((head_ + r) % window_));
+            }
+            rank_update();
+        }
+
+        /* X^T . X over the window */
+        void gram(MatrixImpl<T, D, D> &result) const noexcept
+        {
+            for (std::size_t i = 0; i < D; i++)
+            {
+                for (std::size_t j = i; j < D; j++)
+                {
+                    result.data()[i][j] = gram_[i * D + j];
+                    result.data()[j][i] = gram_[i * D + j];
+                }
+            }
+        }
+        [[nodiscard]] MatrixImpl<T, D, D> gram() const noexcept
+        {
+            MatrixImpl<T, D, D> result{};
+            gram(result);
+            return result;
+        }
+
+        [[nodiscard]] Row mean() const noexcept
+        {
+            Row result{};
+            for (std::size_t j = 0; j < D; j++)
+            {
+                result[j] = size_ > 0 ? sum_[j] / static_cast<T>(size_) : T{0};
+            }
+            return result;
+        }
+
+        /* Sample covariance (G - n . mean . mean^T) / (n - 1), zero with less than 2 rows */
+        void covariance(MatrixImpl<T, D, D> &result) const noexcept
+        {
+            const auto n = static_cast<T>(size_);
+            for (std::size_t i = 0; i < D; i++)
+            {
+                for (std::size_t j = i; j < D; j++)
+                {
+                    auto value = size_ > 1 ? (gram_[i * D + j] - sum_[i] * sum_[j] / n) / (n - 1) : T{0};
+                    result.data()[i][j] = value;
+                    result.data()[j][i] = value;
+                }
+            }
+        }
+        [[nodiscard]] MatrixImpl<T, D, D> covariance() const noexcept
+        {
+            MatrixImpl<T, D, D> result{};
+            covariance(result);
+            return result;
+        }
+
+    private:
+        T *slot(std::size_t index) noexcept { return rows_.data() + index * D; }
+
+        /* G += sum x . x^T over entering_, G -= sum x . x^T over leaving_ */
+        /* Row i of G is swept once per batch, the inner loop over j is contiguous */
+        void rank_update() noexcept
+        {
+            for (std::size_t i = 0; i < D; i++)
+            {
+                auto *g_i = gram_.data() + i * D;
+                for (const auto *x : entering_)
+                {
+                    auto x_i = x[i];
+                    for (std::size_t j = i; j < D; j++)
+                    {
+                        g_i[j] += x_i * x[j];
+                    }
+                }
+                for (const auto *x : leaving_)
+                {
+                    auto x_i = x[i];
+                    for (std::size_t j = i; j < D; j++)
+                    {
+                        g_i[j] -= x_i * x[j];
+                    }
+                }
+            }
+            for (const auto *x : entering_)
+            {
+                for (std::size_t j = 0; j < D; j++)
+                {
+                    sum_[j] += x[j];
+                }
+            }
+            for (const auto *x : leaving_)
+            {
+                for (std::size_t j = 0; j < D; j++)
+                {
+                    sum_[j] -= x[j];
+                }
+            }
+        }
+
+        std::size_t window_;
+        /* ring buffer of the rows in the window, oldest at head_ */
+        memory::AlignedVector<T> rows_{};
+        std::size_t head_{0};
+        std::size_t size_{0};
+        /* upper triangle of X^T . X, row major D x D */
+        memory::AlignedVector<T> gram_{};
+        Row sum_{};
+        /* rows of the current update, the capacity is kept between ticks */
+        std::vector<const T *> entering_{};
+        std::vector<const T *> leaving_{};
+    };
+}
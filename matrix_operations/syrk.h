@@ -0,0 +1,233 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+#include <matrix_operations/matrix.h>
+#include <matrix_operations/allocator.h>
+
+/* Symmetric rank k update (SYRK) and packed symmetric storage. */
+/* A . A^T and A^T . A are symmetric, only one triangle is computed, which halves the flops. */
+/* Row i of the upper triangle holds N - i elements and row i of the lower one i + 1, */
+/* so the rows are split into bands of equal area instead of equal height. */
+namespace matrix
+{
+    enum class Triangle
+    {
+        upper,
+        lower,
+    };
+
+    /* Symmetric N x N matrix, the upper triangle packed row by row (N (N + 1) / 2 elements) */
+    template <typename T, std::size_t N>
+    class SymmetricMatrix
+    {
+    public:
+        static constexpr std::size_t packed_size{N * (N + 1) / 2};
+
+        SymmetricMatrix() : data_(packed_size, T{0}) {}
+        /* the upper triangle of m */
+        explicit SymmetricMatrix(const MatrixImpl<T, N, N> &m) : SymmetricMatrix()
+        {
+            for (std::size_t i = 0; i < N; i++)
+            {
+                for (std::size_t j = i; j < N; j++)
+                {
+                    data_[index(i, j)] = m.data()[i][j];
+                }
+            }
+        }
+
+        static constexpr std::size_t rows() noexcept { return N; }
+        static constexpr std::size_t columns() noexcept { return N; }
+
+        /* position of (i, j) and (j, i) in the packed array */
+        [[nodiscard]] static constexpr std::size_t index(std::size_t i, std::size_t j) noexcept
+        {
+            if (i > j)
+                std::swap(i, j);
+            return i * (2 * N - i + 1) / 2 + (j - i);
+        }
+
+        [[nodiscard]] T &operator()(std::size_t i, std::size_t j) noexcept { return data_[index(i, j)]; }
+        [[nodiscard]] const T &operator()(std::size_t i, std::size_t j) const noexcept { return data_[index(i, j)]; }
+
+        [[nodiscard]] T *data() noexcept { return data_.data(); }
+        [[nodiscard]] const T *data() const noexcept { return data_.data(); }
+
+        /* both triangles */
+        void to_matrix(MatrixImpl<T, N, N> &result) const noexcept
+        {
+            for (std::size_t i = 0; i < N; i++)
+            {
+                for (std::size_t j = i; j < N; j++)
+                {
+                    result.data()[i][j] = data_[index(i, j)];
+                    result.data()[j][i] = data_[index(i, j)];
+                }
+            }
+        }
+
+    private:
+        memory::AlignedVector<T> data_;
+    };
+
+    /* out(i, j) returns the element of the result. The elements of one row of the triangle */
+    /* are contiguous, in a MatrixImpl row as well as in the packed upper triangle. */
+    namespace detail
+    {
+        /* columns of row i in the triangle */
+        constexpr std::pair<std::size_t, std::size_t> triangle_row(std::size_t i, std::size_t n, Triangle triangle) noexcept
+        {
+            return triangle == Triangle::upper ? std::pair{i, n} : std::pair{std::size_t{0}, i + 1};
+        }
+
+        /* Row bands of an n x n triangle with about the same number of elements each */
+        inline std::vector<std::pair<std::size_t, std::size_t>> triangular_chunks(std::size_t n, Triangle triangle, std::size_t number_of_chunks)
+        {
+            std::vector<std::pair<std::size_t, std::size_t>> chunks{};
+            const auto total = n * (n + 1) / 2;
+            std::size_t start{0};
+            std::size_t area{0};
+            for (std::size_t i = 0; i < n; i++)
+            {
+                const auto [begin, end] = triangle_row(i, n, triangle);
+                area += end - begin;
+                /* close the band once it holds its share of the triangle */
+                if (area * number_of_chunks >= total * (chunks.size() + 1) || i + 1 == n)
+                {
+                    chunks.emplace_back(start, i + 1);
+                    start = i + 1;
+                }
+            }
+            return chunks;
+        }
+
+        template <std::size_t N>
+        inline const std::vector<std::pair<std::size_t, std::size_t>> &triangular_chunks(Triangle triangle)
+        {
+            /* one set of bands per size and triangle, like MatrixImpl::chunks_ */
+            static const auto upper = triangular_chunks(N, Triangle::upper, 8);
+            static const auto lower = triangular_chunks(N, Triangle::lower, 8);
+            return triangle == Triangle::upper ? upper : lower;
+        }
+
+        /* out(i, j) = alpha . A[i] . A[j] + beta . out(i, j) for the rows start to end of the triangle */
+        template <typename Out, typename T, std::size_t Rows, std::size_t Columns>
+        inline void syrk_aux(Out &&out, const MatrixImpl<T, Rows, Columns> &a, Triangle triangle, T alpha, T beta, std::size_t start, std::size_t end) noexcept
+        {
+            for (std::size_t i{start}; i < end; i++)
+            {
+                const auto &a_i = a.data()[i];
+                const auto [begin, last] = triangle_row(i, Rows, triangle);
+                auto *r_i = &out(i, begin) - begin;
+                auto store = [r_i, alpha, beta](std::size_t j, T sum)
+                { r_i[j] = beta == T{0} ? alpha * sum : alpha * sum + beta * r_i[j]; };
+                std::size_t j{begin};
+                /* 4 dot products share every load of A[i] (as in gemv_aux) */
+                for (; j + 4 <= last; j += 4)
+                {
+                    const auto &a_j0 = a.data()[j];
+                    const auto &a_j1 = a.data()[j + 1];
+                    const auto &a_j2 = a.data()[j + 2];
+                    const auto &a_j3 = a.data()[j + 3];
+                    T sum0{0};
+                    T sum1{0};
+                    T sum2{0};
+                    T sum3{0};
+                    for (std::size_t k = 0; k < Columns; k++)
+                    {
+                        auto a_ik = a_i[k];
+                        sum0 += a_ik * a_j0[k];
+                        sum1 += a_ik * a_j1[k];
+                        sum2 += a_ik * a_j2[k];
+                        sum3 += a_ik * a_j3[k];
+                    }
+                    store(j, sum0);
+                    store(j + 1, sum1);
+                    store(j + 2, sum2);
+                    store(j + 3, sum3);
+                }
+                for (; j < last; j++)
+                {
+                    const auto &a_j = a.data()[j];
+                    T sum{0};
+                    for (std::size_t k = 0; k < Columns; k++)
+                    {
+                        sum += a_i[k] * a_j[k];
+                    }
+                    store(j, sum);
+                }
+            }
+        }
+
+        /* out(i, j) = alpha . A[:, i] . A[:, j] + beta . out(i, j), as rank 1 updates with the rows of A */
+        template <typename Out, typename T, std::size_t Rows, std::size_t Columns>
+        inline void syrk_transposed_aux(Out &&out, const MatrixImpl<T, Rows, Columns> &a, Triangle triangle, T alpha, T beta, std::size_t start, std::size_t end) noexcept
+        {
+            for (std::size_t i{start}; i < end; i++)
+            {
+                const auto [begin, last] = triangle_row(i, Columns, triangle);
+                auto *r_i = &out(i, begin) - begin;
+                for (std::size_t j{begin}; j < last; j++)
+                {
+                    r_i[j] = beta == T{0} ? T{0} : beta * r_i[j];
+                }
+            }
+            for (std::size_t k = 0; k < Rows; k++)
+            {
+                const auto &a_k = a.data()[k];
+                for (std::size_t i{start}; i < end; i++)
+                {
+                    auto a_ki = alpha * a_k[i];
+                    const auto [begin, last] = triangle_row(i, Columns, triangle);
+                    auto *r_i = &out(i, begin) - begin;
+                    for (std::size_t j{begin}; j < last; j++)
+                    {
+                        r_i[j] += a_ki * a_k[j];
+                    }
+                }
+            }
+        }
+    }
+
+    /* triangle of R = alpha . A . A^T + beta . R, the other triangle is not touched */
+    template <typename T, std::size_t Rows, std::size_t Columns>
+    inline void syrk(MatrixImpl<T, Rows, Rows> &result, const MatrixImpl<T, Rows, Columns> &a, Triangle triangle = Triangle::upper, T alpha = T{1}, T beta = T{0}, const execution::Policy &policy = execution::automatic)
+    {
+        execution::run(policy, detail::triangular_chunks<Rows>(triangle), [&](std::size_t start, std::size_t end)
+                       { detail::syrk_aux([&result](std::size_t i, std::size_t j) -> T &
+                                          { return result.data()[i][j]; },
+                                          a, triangle, alpha, beta, start, end); });
+    }
+
+    /* R = alpha . A . A^T + beta . R in packed storage */
+    template <typename T, std::size_t Rows, std::size_t Columns>
+    inline void syrk(SymmetricMatrix<T, Rows> &result, const MatrixImpl<T, Rows, Columns> &a, T alpha = T{1}, T beta = T{0}, const execution::Policy &policy = execution::automatic)
+    {
+        execution::run(policy, detail::triangular_chunks<Rows>(Triangle::upper), [&](std::size_t start, std::size_t end)
+                       { detail::syrk_aux([&result](std::size_t i, std::size_t j) -> T &
+                                          { return result(i, j); },
+                                          a, Triangle::upper, alpha, beta, start, end); });
+    }
+
+    /* triangle of R = alpha . A^T . A + beta . R (Gram matrix), the other triangle is not touched */
+    template <typename T, std::size_t Rows, std::size_t Columns>
+    inline void syrk_transposed(MatrixImpl<T, Columns, Columns> &result, const MatrixImpl<T, Rows, Columns> &a, Triangle triangle = Triangle::upper, T alpha = T{1}, T beta = T{0}, const execution::Policy &policy = execution::automatic)
+    {
+        execution::run(policy, detail::triangular_chunks<Columns>(triangle), [&](std::size_t start, std::size_t end)
+                       { detail::syrk_transposed_aux([&result](std::size_t i, std::size_t j) -> T &
+                                                     { return result.data()[i][j]; },
+                                                     a, triangle, alpha, beta, start, end); });
+    }
+
+    /* R = alpha . A^T . A + beta . R in packed storage */
+    template <typename T, std::size_t Rows, std::size_t Columns>
+    inline void syrk_transposed(SymmetricMatrix<T, Columns> &result, const MatrixImpl<T, Rows, Columns> &a, T alpha = T{1}, T beta = T{0}, const execution::Policy &policy = execution::automatic)
+    {
+        execution::run(policy, detail::triangular_chunks<Columns>(Triangle::upper), [&](std::size_t start, std::size_t end)
+                       { detail::syrk_transposed_aux([&result](std::size_t i, std::size_t j) -> T &
+                                                     { return result(i, j); },
+                                                     a, Triangle::upper, alpha, beta, start, end); });
+    }
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <latch>
+#include <memory>
+#include <vector>
+#include <matrix_operations/thread_pool.h>
+
+namespace thread_pool
+{
+    /* Dependency graph of tasks executed on a thread pool. */
+    /* A node is queued as soon as its last dependency completes (no global barrier), */
+    /* so independent nodes run on different workers at the same time. */
+    /* The graph can be run any number of times. */
+    class TaskGraph
+    {
+    public:
+        using NodeId = std::size_t;
+        using Dependencies = std::vector<NodeId>;
+
+        TaskGraph() = default;
+        TaskGraph(const TaskGraph &) = delete;
+        TaskGraph(TaskGraph &&) = default;
+
+        /* Dependencies must already be in the graph, which keeps the graph acyclic */
+        NodeId add(std::function<void()> func, const Dependencies &dependencies = {})
+        {
+            const NodeId id = nodes_.size();
+            auto &node = nodes_.emplace_back();
+            node.func = std::move(func);
+            node.dependencies = dependencies.size();
+            for (auto dependency : dependencies)
+            {
+                nodes_[dependency].successors.push_back(id);
+            }
+            return id;
+        }
+
+        [[nodiscard]] std::size_t size() const noexcept { return nodes_.size(); }
+
+        /* Execute every node and block until all of them are done. */
+        /* Runs on the caller in dependency order if the pool has not been started, or if the */
+        /* caller is itself a pool worker: blocking a worker on nodes queued behind it could */
+        /* leave no thread to run them. */
+        template <typename Pool>
+        void run(Pool &tp)
+        {
+            if (nodes_.empty())
+                return;
+
+            for (auto &node : nodes_)
+            {
+                node.pending.store(node.dependencies, std::memory_order_relaxed);
+            }
+
+            if (tp.workers_.empty() || this_thread_is_worker())
+            {
+                run_inline();
+                return;
+            }
+
+            std::latch graph_complete{static_cast<std::ptrdiff_t>(nodes_.size())};
+            for (NodeId id = 0; id < nodes_.size(); id++)
+            {
+                if (nodes_[id].dependencies == 0)
+                {
+                    enqueue(tp, id, graph_complete);
+                }
+            }
+            graph_complete.wait();
+        }
+
+    private:
+        struct Node
+        {
+            std::function<void()> func{};
+            std::vector<NodeId> successors{};
+            std::size_t dependencies{0};
+            std::atomic<std::size_t> pending{0};
+        };
+
+        template <typename Pool>
+        void enqueue(Pool &tp, NodeId id, std::latch &graph_complete)
+        {
+            auto task = std::make_shared<Task>([this, &tp, id, &graph_complete]()
+                                               {
+                auto &node = nodes_[id];
+                node.func();
+                /* the last dependency to complete releases the successor */
+                for (auto successor : node.successors)
+                {
+                    if (nodes_[successor].pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                    {
+                        enqueue(tp, successor, graph_complete);
+                    }
+                }
+                graph_complete.count_down(); });
+
+            tp.submit(task);
+        }
+
+        /* Kahn's algorithm on the calling thread */
+        void run_inline()
+        {
+            std::vector<NodeId> ready{};
+            for (NodeId id = 0; id < nodes_.size(); id++)
+            {
+                if (nodes_[id].dependencies == 0)
+                    ready.push_back(id);
+            }
+            while (!ready.empty())
+            {
+                auto id = ready.back();
+                ready.pop_back();
+                nodes_[id].func();
+                for (auto successor : nodes_[id].successors)
+                {
+                    if (nodes_[successor].pending.fetch_sub(1, std::memory_order_relaxed) == 1)
+                        ready.push_back(successor);
+                }
+            }
+        }
+
+        /* deque, nodes hold atomics and must not move */
+        std::deque<Node> nodes_{};
+    };
+}
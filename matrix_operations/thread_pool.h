@@ -1,17 +1,25 @@
 #pragma once
 
 #include <thread>
+#include <atomic>
+#include <functional>
+#include <type_traits>
 #include <mutex>
 #include <condition_variable>
 #include <latch>
 #include <memory>
+#include <vector>
+#include <algorithm>
 #include <iostream>
+#include <boost/lockfree/queue.hpp>
 #include <boost/lockfree/spsc_queue.hpp>
 #include <boost/atomic.hpp>
 #include <boost/thread.hpp>
 #include <boost/thread/mutex.hpp>
 #include <chrono>
+#include <cstdint>
 #include <queue>
+#include <stop_token>
 
 namespace thread_pool
 {
@@ -29,6 +37,26 @@ namespace thread_pool
         std::function<void()> func_;
     };
 
+    namespace detail
+    {
+        inline thread_local bool worker_thread{false};
+    }
+
+    /* True on the worker threads of any pool */
+    inline bool this_thread_is_worker() noexcept
+    {
+        return detail::worker_thread;
+    }
+
+    /* Scheduling class of a job */
+    enum class Priority
+    {
+        /* latency critical, runs ahead of everything queued as normal */
+        high,
+        /* bulk work */
+        normal,
+    };
+
     class WorkerBlocking
     {
     public:
@@ -145,41 +173,121 @@ namespace thread_pool
         TaskQueue queue_{};
     };
 
+    /* Bounded MPMC queue of tasks, any thread can push and pop. boost::lockfree::queue */
+    /* needs a trivial type, so the queue owns a heap allocated TaskPtr per queued task. */
+    class TaskQueueLockFree
+    {
+    public:
+        using TaskPtr = std::shared_ptr<Task>;
+
+        explicit TaskQueueLockFree(std::size_t capacity) : queue_(capacity) {}
+        TaskQueueLockFree(const TaskQueueLockFree &) = delete;
+        ~TaskQueueLockFree()
+        {
+            TaskPtr *task{nullptr};
+            while (queue_.pop(task))
+            {
+                delete task;
+            }
+        }
+
+        /* false if the queue is full, the task is not queued */
+        bool push(const TaskPtr &task)
+        {
+            auto owner = std::make_unique<TaskPtr>(task);
+            if (!queue_.bounded_push(owner.get()))
+                return false;
+            owner.release();
+            return true;
+        }
+
+        /* Pop and execute one task, false if the queue was empty */
+        bool run_one()
+        {
+            TaskPtr *task{nullptr};
+            if (!queue_.pop(task))
+                return false;
+            const std::unique_ptr<TaskPtr> owner{task};
+            (*owner->get())();
+            return true;
+        }
+
+    private:
+        boost::lockfree::queue<TaskPtr *> queue_;
+    };
+
     class WorkerLockFree
     {
     public:
         using TaskPtr = std::shared_ptr<Task>;
-        using TaskQueue = boost::lockfree::spsc_queue<TaskPtr>;
+        using TaskQueue = TaskQueueLockFree;
+        static constexpr std::size_t default_capacity{1024};
+        /* empty polls before the worker parks until a task is queued */
+        static constexpr std::size_t spin_limit{1024};
 
-        WorkerLockFree() = default;
+        explicit WorkerLockFree(std::size_t capacity = default_capacity) : queue_(capacity) {}
         WorkerLockFree(const WorkerLockFree &) = delete;
-        WorkerLockFree(WorkerLockFree &&) = default;
+        WorkerLockFree(WorkerLockFree &&) = delete;
+
+        /* The pool's high priority queue is checked before the worker's own queue. */
+        /* A reserved worker only runs high priority tasks. Call before the thread starts. */
+        void attach_priority_queue(TaskQueue *priority, bool reserved) noexcept
+        {
+            priority_ = priority;
+            reserved_ = reserved;
+        }
 
         void run(std::stop_token token)
         {
+            const std::stop_callback stop{token, [this]()
+                                          { wake(); }};
+            auto run_one = [this]()
+            { return (priority_ && priority_->run_one()) || (!reserved_ && queue_.run_one()); };
+
+            std::size_t idle{0};
             while (!token.stop_requested())
             {
-                if (queue_.read_available() > 0)
+                if (run_one())
                 {
-                    const auto task = queue_.front();
-                    queue_.pop();
-                    (*task.get())();
+                    idle = 0;
+                    continue;
                 }
+                if (++idle <= spin_limit)
+                    continue;
+
+                /* park: a task queued after epoch was read changes wake_, so wait returns */
+                parked_.store(true);
+                const auto epoch = wake_.load();
+                if (!token.stop_requested() && !run_one())
+                    wake_.wait(epoch);
+                parked_.store(false);
+                idle = 0;
             }
         }
 
+        /* false if the queue is full, the task is not queued */
         bool enqueue(const TaskPtr &task)
         {
-            if (queue_.write_available())
-            {
-                queue_.push(task);
-                return true;
-            }
-            return false;
+            if (!queue_.push(task))
+                return false;
+            wake();
+            return true;
+        }
+
+        /* Unpark the worker if it sleeps, e.g. after a push to the priority queue */
+        void wake() noexcept
+        {
+            wake_.fetch_add(1);
+            if (parked_.load())
+                wake_.notify_one();
         }
 
     private:
-        TaskQueue queue_{5};
+        TaskQueue queue_;
+        TaskQueue *priority_{nullptr};
+        bool reserved_{false};
+        std::atomic<std::uint32_t> wake_{0};
+        std::atomic<bool> parked_{false};
     };
 
     template <typename Worker>
@@ -190,15 +298,87 @@ namespace thread_pool
         ThreadPoolImpl(const ThreadPoolImpl &) = delete;
         ThreadPoolImpl(ThreadPoolImpl &&) noexcept = default;
 
-        void init(std::size_t number_of_threads)
+        /* Workers with a priority lane check a pool wide high priority queue first */
+        static constexpr bool has_priority_lanes = requires(Worker &worker, TaskQueueLockFree *queue) { worker.attach_priority_queue(queue, true); };
+
+        /* Number of workers kept free for high priority tasks, call before init. */
+        /* At least one worker is left for normal tasks. */
+        void reserve(std::size_t reserved) noexcept
+        {
+            reserved_ = reserved;
+        }
+
+        /* args are passed to every worker, e.g. the queue capacity of WorkerLockFree */
+        template <typename... Args>
+        void init(std::size_t number_of_threads, const Args &...args)
         {
             for (std::size_t i = 0; i < number_of_threads; i++)
             {
-                workers_.emplace_back(std::make_shared<Worker>());
+                workers_.emplace_back(std::make_shared<Worker>(args...));
+            }
+            if constexpr (has_priority_lanes)
+            {
+                reserved_ = std::min(reserved_, workers_.empty() ? 0 : workers_.size() - 1);
+                for (std::size_t i = 0; i < workers_.size(); i++)
+                {
+                    workers_[i]->attach_priority_queue(&priority_queue_, i >= workers_.size() - reserved_);
+                }
+            }
+            else
+            {
+                reserved_ = 0;
             }
             for (const auto &worker : workers_)
             {
-                threads_.emplace_back(std::bind_front(&Worker::run, worker.get()));
+                threads_.emplace_back([worker = worker.get()](std::stop_token token)
+                                      {
+                    detail::worker_thread = true;
+                    worker->run(token); });
+            }
+        }
+
+        /* Queue a task on the next worker with room in its queue. Safe from any number of threads. */
+        /* High priority tasks go to the shared priority queue, which every idle worker takes from. */
+        /* If the queues are full the task runs on the calling thread, so producers are slowed */
+        /* down instead of the task being dropped (caller runs back-pressure). */
+        void submit(const std::shared_ptr<Task> &task, Priority priority = Priority::normal)
+        {
+            if constexpr (has_priority_lanes)
+            {
+                if (priority == Priority::high && !workers_.empty())
+                {
+                    if (!priority_queue_.push(task))
+                    {
+                        (*task.get())();
+                        return;
+                    }
+                    for (const auto &worker : workers_)
+                    {
+                        worker->wake();
+                    }
+                    return;
+                }
+            }
+
+            const auto shared = workers_.size() - reserved_;
+            const auto first = next_worker_.fetch_add(1, std::memory_order_relaxed);
+            for (std::size_t i = 0; i < shared; i++)
+            {
+                if (workers_[(first + i) % shared]->enqueue(task))
+                    return;
+            }
+            (*task.get())();
+        }
+
+        /* Run the queued high priority tasks on the calling thread. */
+        /* Called by bulk jobs between chunks, so latency critical work doesn't wait for the whole job. */
+        void run_priority()
+        {
+            if constexpr (has_priority_lanes)
+            {
+                while (priority_queue_.run_one())
+                {
+                }
             }
         }
 
@@ -213,14 +393,193 @@ namespace thread_pool
 
         using Workers = std::vector<std::shared_ptr<Worker>>;
         Workers workers_{};
+        /* declared before threads_, the workers stop before the queue goes away */
+        TaskQueueLockFree priority_queue_{WorkerLockFree::default_capacity};
+        /* the last reserved_ workers only run high priority tasks */
+        std::size_t reserved_{0};
         using Threads = std::vector<std::jthread>;
         Threads threads_{};
+        /* fork_join helpers queued or running, the pool is saturated once every worker has one */
+        std::atomic<std::size_t> busy_{0};
+        /* round robin position for submit */
+        std::atomic<std::size_t> next_worker_{0};
     };
 
     
+    /* How the submitting thread takes part in a fork/join */
+    enum class ForkJoin
+    {
+        /* Chunks run on the workers only, the caller waits. On a worker thread it falls back to */
+        /* caller_participates, a blocked worker could hold up its own helpers. */
+        pool_only,
+        /* The caller claims chunks like a worker and only waits for the chunks already taken */
+        caller_participates,
+        /* As caller_participates, but everything runs on the caller if the pool is saturated */
+        inline_when_saturated,
+    };
+
+    /* A normal priority fork/join on a pool with priority lanes is split into about this many */
+    /* pieces per worker, so a helper checks the priority queue several times per job */
+    inline constexpr std::size_t priority_pieces_per_worker{4};
+
+    /* Split every chunk into pieces of at most max_size, so a bulk job yields to */
+    /* high priority work (and balances across workers) at a finer grain */
+    template <typename Chunks>
+    inline std::vector<std::pair<std::size_t, std::size_t>> split_chunks(const Chunks &chunks, std::size_t max_size)
+    {
+        std::vector<std::pair<std::size_t, std::size_t>> pieces{};
+        max_size = std::max<std::size_t>(max_size, 1);
+        for (const auto &[start, end] : chunks)
+        {
+            for (auto piece = start; piece < end; piece += max_size)
+            {
+                pieces.emplace_back(piece, std::min(end, piece + max_size));
+            }
+        }
+        return pieces;
+    }
+
+    /* Execute func(start, end) for each chunk and block until all chunks are done. */
+    /* With caller participation the chunks are claimed dynamically from a shared counter, */
+    /* so the caller drains the job while it waits and helpers that start late find nothing left. */
+    /* Helpers of normal priority jobs run queued high priority tasks between chunks, and those */
+    /* jobs are split to at most 1 / priority_pieces_per_worker of a worker's share per chunk, */
+    /* so a high priority task waits for a piece and not for a whole chunk. */
+    /* func must accept any sub range of a chunk. */
+    /* Runs on the caller if the pool has not been started. */
+    template <typename Pool, typename Chunks, typename F>
+    inline void fork_join(Pool &tp, const Chunks &chunks, const F &func, ForkJoin mode = ForkJoin::caller_participates, Priority priority = Priority::normal)
+    {
+        if (mode == ForkJoin::pool_only && this_thread_is_worker())
+            mode = ForkJoin::caller_participates;
+        auto &workers = tp.workers_;
+        const auto available = priority == Priority::high ? workers.size() : workers.size() - tp.reserved_;
+        const bool saturated = tp.busy_.load(std::memory_order_relaxed) >= available;
+        if (workers.empty() || (mode == ForkJoin::inline_when_saturated && saturated) || (mode != ForkJoin::pool_only && chunks.size() <= 1))
+        {
+            for (const auto &[start, end] : chunks)
+            {
+                func(start, end);
+            }
+            return;
+        }
+
+        if constexpr (Pool::has_priority_lanes)
+        {
+            if (priority == Priority::normal)
+            {
+                std::size_t total{0};
+                std::size_t largest{0};
+                for (const auto &[start, end] : chunks)
+                {
+                    total += end - start;
+                    largest = std::max(largest, end - start);
+                }
+                const auto pieces = priority_pieces_per_worker * available;
+                const auto max_size = (total + pieces - 1) / pieces;
+                if (largest > max_size)
+                {
+                    fork_join(tp, split_chunks(chunks, max_size), func, mode, priority);
+                    return;
+                }
+            }
+        }
+
+        /* Outlives the call, helpers may start after the last chunk was taken */
+        struct Job
+        {
+            explicit Job(std::size_t chunks) : number_of_chunks(chunks), work_complete(static_cast<std::ptrdiff_t>(chunks)) {}
+            const std::size_t number_of_chunks;
+            std::atomic<std::size_t> next{0};
+            std::latch work_complete;
+        };
+        auto job = std::make_shared<Job>(chunks.size());
+
+        /* func and chunks are only touched after a chunk is claimed, i.e. before the caller returns */
+        auto drain = [job, &chunks, &func, &tp, priority](bool helper)
+        {
+            for (std::size_t i{}; (i = job->next.fetch_add(1, std::memory_order_relaxed)) < job->number_of_chunks;)
+            {
+                func(chunks[i].first, chunks[i].second);
+                job->work_complete.count_down();
+                if (helper && priority == Priority::normal)
+                {
+                    tp.run_priority();
+                }
+            }
+        };
+
+        /* one helper per chunk the caller won't take, at most one per worker */
+        auto helpers = std::min(available, mode == ForkJoin::pool_only ? chunks.size() : chunks.size() - 1);
+        for (std::size_t i = 0; i < helpers; i++)
+        {
+            tp.busy_.fetch_add(1, std::memory_order_relaxed);
+            auto task = std::make_shared<Task>([drain, &tp]()
+                                               {
+                drain(true);
+                tp.busy_.fetch_sub(1, std::memory_order_relaxed); });
+            tp.submit(task, priority);
+        }
+
+        if (mode != ForkJoin::pool_only)
+        {
+            drain(false);
+        }
+        job->work_complete.wait();
+    }
+
+    /* Execute func(start, end) for each chunk on the pool and block until all chunks are done. */
+    /* The caller computes its share of the chunks instead of sitting idle. */
+    template <typename Pool, typename Chunks, typename F>
+    inline void run_chunks(Pool &tp, const Chunks &chunks, const F &func)
+    {
+        fork_join(tp, chunks, func, ForkJoin::caller_participates);
+    }
+
+    /* Non blocking variant of run_chunks. func(start, end) runs for each chunk on the pool workers */
+    /* and the worker that completes the last chunk calls done(). The caller returns immediately. */
+    /* Runs inline (done() included) if the pool has not been started. */
+    template <typename Pool, typename Chunks, typename F, typename Done>
+    inline void run_chunks_async(Pool &tp, const Chunks &chunks, F &&func, Done &&done, Priority priority = Priority::normal)
+    {
+        auto &workers = tp.workers_;
+        if (workers.empty() || chunks.empty())
+        {
+            for (const auto &[start, end] : chunks)
+            {
+                func(start, end);
+            }
+            done();
+            return;
+        }
+
+        /* Shared by all the chunk tasks, released with the last one */
+        struct Job
+        {
+            Job(F &&f, Done &&d, std::size_t chunks) : func(std::forward<F>(f)), done(std::forward<Done>(d)), remaining(chunks) {}
+            std::decay_t<F> func;
+            std::decay_t<Done> done;
+            std::atomic<std::size_t> remaining;
+        };
+        auto job = std::make_shared<Job>(std::forward<F>(func), std::forward<Done>(done), chunks.size());
+
+        for (std::size_t i = 0; i < chunks.size(); i++)
+        {
+            auto [start, end] = chunks[i];
+            auto task = std::make_shared<Task>([job, start, end]()
+                                               {
+                job->func(start, end);
+                if (job->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                {
+                    job->done();
+                } });
+            tp.submit(task, priority);
+        }
+    }
+
     // using Worker = WorkerBlocking;
-    using Worker = WorkerBlockingSpin;
-    //using Worker = WorkerLockFree;
+    // using Worker = WorkerBlockingSpin;
+    using Worker = WorkerLockFree;
     
     using ThreadPool = ThreadPoolImpl<Worker>;
 
@@ -228,9 +587,12 @@ namespace thread_pool
     class ThreadPoolInstance
     {
     public:
+        /* every instance shares the pool, only the first one starts the workers, */
+        /* one per hardware thread (execution::shared_pool also caps it by the thread budget) */
         ThreadPoolInstance()
         {
-            tp.init(8);
+            std::call_once(init_flag_, []()
+                           { tp.init(std::max(std::thread::hardware_concurrency(), 1u)); });
         }
         ThreadPoolInstance(const ThreadPoolInstance&) = delete;
         ThreadPoolInstance(ThreadPoolInstance&&) = delete;
@@ -243,5 +605,6 @@ namespace thread_pool
     private:
 
         inline static ThreadPool tp{};
+        inline static std::once_flag init_flag_{};
     };
 }
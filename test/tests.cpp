@@ -4,6 +4,27 @@
 #include <matrix_operations/matrix_util.h>
 #include <matrix_operations/matrix_impl_2.h>
 #include <matrix_operations/strassens_algorithm.h>
+#include <matrix_operations/block_sparse_matrix.h>
+#include <matrix_operations/matrix_chain.h>
+#include <matrix_operations/matrix_file.h>
+#include <matrix_operations/out_of_core.h>
+#include <matrix_operations/matrix_async.h>
+#include <matrix_operations/matrix_graph.h>
+#include <matrix_operations/allocator.h>
+#include <matrix_operations/packed_matrix.h>
+#include <matrix_operations/incremental_product.h>
+#include <matrix_operations/streaming_gram.h>
+#include <matrix_operations/syrk.h>
+#include <matrix_operations/lu.h>
+#include <matrix_operations/cholesky.h>
+#include <matrix_operations/matrix_power.h>
+#include <matrix_operations/semiring.h>
+#include <matrix_operations/bit_matrix.h>
+#include <matrix_operations/complex_matrix.h>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
 
 using namespace std::string_literals;
 using namespace ::matrix;
@@ -232,3 +253,1819 @@ TEST(Multiplication, n_n_matrices_tiled)
     validate_m_n_matrix_2<64, 64>();
     validate_m_n_matrix_2<128, 128>();
 }
+
+/* Block sparse: keep only the elements within bandwidth of the diagonal */
+template <std::size_t N>
+void make_banded(Matrix<N, N> &m, std::size_t bandwidth)
+{
+    for (std::size_t i = 0; i < N; i++)
+    {
+        for (std::size_t j = 0; j < N; j++)
+        {
+            if ((i > j ? i - j : j - i) >= bandwidth)
+                m.data()[i][j] = 0;
+        }
+    }
+}
+
+template <std::size_t N>
+void validate_block_sparse(std::size_t bandwidth)
+{
+    Matrix<N, N> a{};
+    fill_matrix<int>(a);
+    make_banded(a, bandwidth);
+    Matrix<N, N> b{};
+    fill_matrix<int>(b);
+    make_banded(b, bandwidth);
+
+    matrix_tiled::Matrix<N, N> a2{a.data()};
+    matrix_tiled::Matrix<N, N> b2{b.data()};
+    matrix_tiled::BlockSparseMatrix<N, N> as{a2};
+    matrix_tiled::BlockSparseMatrix<N, N> bs{b2};
+
+    /* only the tiles touching the band are stored */
+    EXPECT_LT(as.non_zero_blocks(), as.row_blocks() * as.column_blocks());
+
+    auto r = a2.multiplication_tiled(b2);
+    EXPECT_EQ((as * bs).to_dense(), r);
+    EXPECT_EQ(as.multiplication_tiled(b2), r);
+}
+
+TEST(Multiplication, n_n_matrices_block_sparse)
+{
+    validate_block_sparse<16>(1);
+    validate_block_sparse<32>(3);
+    validate_block_sparse<64>(6);
+    validate_block_sparse<128>(10);
+}
+
+TEST(Multiplication, block_sparse_empty)
+{
+    matrix_tiled::BlockSparseMatrix<8, 8> a{};
+    matrix_tiled::BlockSparseMatrix<8, 8> b{};
+    EXPECT_EQ((a * b).non_zero_blocks(), 0u);
+    EXPECT_EQ((a * b).to_dense(), (matrix_tiled::Matrix<8, 8>{}));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/* Thread pool workers are only started by the tests that need them */
+inline thread_pool::ThreadPool &test_pool()
+{
+    static thread_pool::ThreadPoolInstance tpi;
+    return thread_pool::ThreadPoolInstance::get_instance();
+}
+
+/* Matrix-Vector: A . x = y and x . A = y */
+template <std::size_t R, std::size_t C>
+void validate_gemv()
+{
+    test_pool();
+
+    Matrix<R, C> a{};
+    fill_matrix<double>(a);
+    Matrix<C, 1> x{};
+    fill_matrix<double>(x);
+    Matrix<1, R> xt{};
+    fill_matrix<double>(xt);
+
+    auto y = a.multiplication_naive(x);
+    validate_double_matrix<R, 1>(a * x, y);
+    validate_double_matrix<R, 1>(gemv_t1(a, x), y);
+    for (const auto &policy : {execution::serial, execution::threads, execution::pool, execution::omp})
+    {
+        validate_double_matrix<R, 1>(gemv_tn_pool(a, x, policy), y);
+    }
+
+    auto yt = xt.multiplication_naive(a);
+    validate_double_matrix<1, C>(xt * a, yt);
+    validate_double_matrix<1, C>(gevm_t1(xt, a), yt);
+    for (const auto &policy : {execution::serial, execution::threads, execution::pool, execution::omp})
+    {
+        validate_double_matrix<1, C>(gevm_tn_pool(xt, a, policy), yt);
+    }
+}
+
+TEST(MatrixVector, gemv_gevm)
+{
+    validate_gemv<3, 3>();
+    validate_gemv<9, 5>();
+    validate_gemv<10, 10>();
+    validate_gemv<101, 67>();
+    validate_gemv<256, 256>();
+    validate_gemv<300, 130>();
+}
+
+template <std::size_t R, std::size_t C, std::size_t B>
+void validate_gemv_batched()
+{
+    test_pool();
+
+    Matrix<R, C> a{};
+    fill_matrix<double>(a);
+    Matrix<B, C> xs{};
+    fill_matrix<double>(xs);
+
+    /* A . X^T = (X . A^T)^T, compare row b against A . x_b */
+    auto r = gemv_batched_t1(a, xs);
+    auto r_pool = gemv_batched_tn_pool(a, xs);
+    for (std::size_t b = 0; b < B; b++)
+    {
+        Matrix<C, 1> x{};
+        for (std::size_t k = 0; k < C; k++)
+        {
+            x.data()[k][0] = xs.data()[b][k];
+        }
+        auto y = a.multiplication_naive(x);
+        for (std::size_t i = 0; i < R; i++)
+        {
+            EXPECT_NEAR(r.data()[b][i], y.data()[i][0], 0.0000001);
+            EXPECT_NEAR(r_pool.data()[b][i], y.data()[i][0], 0.0000001);
+        }
+    }
+}
+
+TEST(MatrixVector, gemv_batched)
+{
+    validate_gemv_batched<3, 3, 1>();
+    validate_gemv_batched<10, 7, 4>();
+    validate_gemv_batched<130, 120, 9>();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/* Matrix chain: A . B . C ... in the optimal order */
+TEST(MatrixChain, optimal_order)
+{
+    /* CLRS example: 30x35, 35x15, 15x5, 5x10, 10x20, 20x25 */
+    constexpr chain::Order<6> order = chain::optimal_order<6>({30, 35, 15, 5, 10, 20, 25});
+    static_assert(order.cost[0][5] == 15125);
+    EXPECT_EQ(chain::parenthesization(order), "((A0 (A1 A2)) ((A3 A4) A5))");
+
+    static_assert(chain::cost_v<Matrix<10, 100>, Matrix<100, 5>, Matrix<5, 50>> == 7500);
+    static_assert(chain::left_to_right_cost<Matrix<50, 5>, Matrix<5, 100>, Matrix<100, 10>>() == 75000);
+    static_assert(chain::cost_v<Matrix<50, 5>, Matrix<5, 100>, Matrix<100, 10>> == 7500);
+}
+
+template <std::size_t R1, std::size_t R2, std::size_t R3, std::size_t R4, std::size_t R5>
+void validate_multiply_chain()
+{
+    Matrix<R1, R2> a{};
+    fill_matrix<double>(a);
+    Matrix<R2, R3> b{};
+    fill_matrix<double>(b);
+    Matrix<R3, R4> c{};
+    fill_matrix<double>(c);
+    Matrix<R4, R5> d{};
+    fill_matrix<double>(d);
+
+    auto r = a * b * c * d;
+    auto r_chain = multiply_chain(a, b, c, d);
+    for (std::size_t i = 0; i < R1; i++)
+    {
+        for (std::size_t j = 0; j < R5; j++)
+        {
+            /* values grow with the chain, compare relative to the magnitude */
+            EXPECT_NEAR(r_chain.data()[i][j], r.data()[i][j], 1e-9 * (1 + std::abs(r.data()[i][j])));
+        }
+    }
+    validate_double_matrix<R1, R3>(multiply_chain(a, b), a * b);
+}
+
+TEST(MatrixChain, multiply_chain)
+{
+    validate_multiply_chain<3, 3, 3, 3, 3>();
+    validate_multiply_chain<50, 5, 100, 10, 2>();
+    validate_multiply_chain<2, 100, 3, 80, 60>();
+    validate_multiply_chain<130, 4, 130, 4, 130>();
+
+    constexpr Matrix<1, 3> a{{{{1, 2, 3}}}};
+    constexpr Matrix<3, 1> b{{{{1}, {2}, {3}}}};
+    constexpr Matrix<1, 1> c{{{{2}}}};
+    static_assert(multiply_chain(a, b, c).data()[0][0] == 28);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/* Binary matrix files: write, mmap and compute on the mapped matrix */
+inline std::string temp_matrix_path(const std::string &name)
+{
+    return (std::filesystem::temp_directory_path() / (name + "_" + std::to_string(::getpid()) + ".mtx")).string();
+}
+
+TEST(MatrixFile, row_major_round_trip)
+{
+    auto path = temp_matrix_path("row_major");
+    Matrix<37, 53> a{};
+    fill_matrix<double>(a);
+    Matrix<53, 20> b{};
+    fill_matrix<double>(b);
+    ASSERT_TRUE(matrix_io::write_matrix(path, a));
+
+    matrix_io::MappedMatrix<Matrix<37, 53>> mapped{path};
+    ASSERT_TRUE(mapped.valid());
+    EXPECT_EQ(mapped.header().data_offset % matrix_io::default_alignment, 0u);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(&mapped.matrix()) % 64, 0u);
+    EXPECT_EQ(mapped.matrix(), a);
+    validate_double_matrix<37, 20>(mapped.matrix() * b, a * b);
+
+    /* dtype, shape and layout must match the requested type */
+    EXPECT_FALSE((matrix_io::MappedMatrix<Matrix<53, 37>>{path}.valid()));
+    EXPECT_FALSE((matrix_io::MappedMatrix<MatrixImpl<float, 37, 53>>{path}.valid()));
+    EXPECT_FALSE((matrix_io::MappedMatrix<Matrix<37, 53>>{path + ".missing"}.valid()));
+
+    matrix_io::MappedMatrixView<double> view{path};
+    ASSERT_TRUE(view.valid());
+    EXPECT_EQ(view.rows(), 37u);
+    EXPECT_EQ(view.columns(), 53u);
+    EXPECT_EQ(view(36, 52), a.data()[36][52]);
+    EXPECT_EQ(view.row(5)[7], a.data()[5][7]);
+
+    std::filesystem::remove(path);
+}
+
+TEST(MatrixFile, tiled_round_trip)
+{
+    auto path = temp_matrix_path("tiled");
+    Matrix<32, 32> a{};
+    fill_matrix<int>(a);
+    matrix_tiled::Matrix<32, 32> a2{a.data()};
+    ASSERT_TRUE(matrix_io::write_matrix(path, a2));
+
+    matrix_io::MappedMatrix<matrix_tiled::Matrix<32, 32>> mapped{path};
+    ASSERT_TRUE(mapped.valid());
+    EXPECT_EQ(mapped.header().layout, matrix_io::Layout::tiled);
+    EXPECT_EQ(mapped.matrix(), a2);
+    EXPECT_EQ(mapped.matrix().multiplication_tiled(a2), a2.multiplication_tiled(a2));
+
+    /* a tiled file is not a row major matrix */
+    EXPECT_FALSE((matrix_io::MappedMatrix<Matrix<32, 32>>{path}.valid()));
+    EXPECT_FALSE((matrix_io::MappedMatrixView<double>{path}.valid()));
+
+    std::filesystem::remove(path);
+}
+
+TEST(MatrixFile, runtime_shape_writer)
+{
+    auto path = temp_matrix_path("runtime");
+    std::vector<float> data(7 * 9);
+    for (std::size_t i = 0; i < data.size(); i++)
+    {
+        data[i] = static_cast<float>(i);
+    }
+    ASSERT_TRUE(matrix_io::write_matrix(path, data.data(), 7, 9));
+
+    matrix_io::MappedMatrix<MatrixImpl<float, 7, 9>> mapped{path};
+    ASSERT_TRUE(mapped.valid());
+    EXPECT_EQ(mapped.matrix().data()[6][8], 62.0f);
+
+    /* the alignment must be a non-zero power of two */
+    EXPECT_FALSE(matrix_io::write_matrix(path, data.data(), 7, 9, 0));
+    EXPECT_FALSE(matrix_io::write_matrix(path, data.data(), 7, 9, 96));
+    EXPECT_FALSE(matrix_io::write_matrix(path, Matrix<2, 2>{}, 0));
+    ASSERT_TRUE(matrix_io::write_matrix(path, data.data(), 7, 9, 64));
+    EXPECT_TRUE((matrix_io::MappedMatrix<MatrixImpl<float, 7, 9>>{path}.valid()));
+
+    std::filesystem::remove(path);
+}
+
+TEST(MatrixFile, rejects_corrupt_header)
+{
+    auto path = temp_matrix_path("corrupt");
+    /* data_offset + data_bytes wraps around to a value inside the file */
+    auto header = matrix_io::make_header<Matrix<2, 2>>();
+    header.data_offset = ~std::uint64_t{0} - 4095;
+    header.data_bytes = 8192;
+    {
+        std::ofstream file{path, std::ios::binary};
+        std::string bytes(8192, '\0');
+        std::memcpy(bytes.data(), &header, sizeof(header));
+        file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    }
+    EXPECT_FALSE(matrix_io::MappedFile{path}.valid());
+
+    /* rows * columns * 8 wraps around to the 64 bytes of data that are there */
+    header = matrix_io::make_header<Matrix<2, 4>>();
+    header.rows = (std::uint64_t{1} << 61) + 1;
+    header.columns = 8;
+    header.data_bytes = 64;
+    {
+        std::ofstream file{path, std::ios::binary};
+        std::string bytes(header.data_offset + header.data_bytes, '\0');
+        std::memcpy(bytes.data(), &header, sizeof(header));
+        file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+    }
+    ASSERT_TRUE(matrix_io::MappedFile{path}.valid());
+    EXPECT_FALSE(matrix_io::MappedMatrixView<double>{path}.valid());
+    EXPECT_FALSE((matrix_io::MappedMatrix<Matrix<2, 4>>{path}.valid()));
+
+    std::filesystem::remove(path);
+}
+
+/* Out of core: operands are larger than the memory budget and are streamed in tiles */
+TEST(OutOfCore, ab_c_larger_than_budget)
+{
+    auto path_a = temp_matrix_path("ooc_a");
+    auto path_b = temp_matrix_path("ooc_b");
+    auto path_c = temp_matrix_path("ooc_c");
+    auto path_r = temp_matrix_path("ooc_r");
+
+    Matrix<70, 50> a{};
+    fill_matrix<double>(a);
+    Matrix<50, 90> b{};
+    fill_matrix<double>(b);
+    Matrix<70, 90> c{};
+    fill_matrix<double>(c);
+    ASSERT_TRUE(matrix_io::write_matrix(path_a, a));
+    ASSERT_TRUE(matrix_io::write_matrix(path_b, b));
+    ASSERT_TRUE(matrix_io::write_matrix(path_c, c));
+
+    /* 16 x 16 tiles, a fraction of the size of each operand */
+    out_of_core::Config config{};
+    config.memory_budget = 5 * 16 * 16 * sizeof(double);
+    EXPECT_EQ(out_of_core::tile_size_for<double>(config), 16u);
+    EXPECT_LT(config.memory_budget, sizeof(a));
+
+    ASSERT_TRUE(out_of_core::multiply(path_a, path_b, path_r, config));
+    {
+        matrix_io::MappedMatrix<Matrix<70, 90>> r{path_r};
+        ASSERT_TRUE(r.valid());
+        validate_double_matrix<70, 90>(r.matrix(), a * b);
+    }
+
+    ASSERT_TRUE(out_of_core::ab_c(path_a, path_b, path_c, path_r, config));
+    {
+        matrix_io::MappedMatrix<Matrix<70, 90>> r{path_r};
+        ASSERT_TRUE(r.valid());
+        validate_double_matrix<70, 90>(r.matrix(), ab_c(a, b, c));
+    }
+
+    /* shape mismatch: A . A */
+    EXPECT_FALSE(out_of_core::multiply(path_a, path_a, path_r, config));
+    EXPECT_FALSE(out_of_core::multiply(path_a + ".missing", path_b, path_r, config));
+
+    /* R may not overwrite an operand, A is left intact */
+    EXPECT_FALSE(out_of_core::ab_c(path_a, path_b, path_c, path_a, config));
+    EXPECT_FALSE(out_of_core::ab_c(path_a, path_b, path_c, path_c, config));
+    {
+        matrix_io::MappedMatrix<Matrix<70, 50>> a_file{path_a};
+        ASSERT_TRUE(a_file.valid());
+        EXPECT_EQ(a_file.matrix(), a);
+    }
+
+    /* an empty inner dimension, R = C */
+    std::vector<double> empty{};
+    ASSERT_TRUE(matrix_io::write_matrix(path_a, empty.data(), 70, 0));
+    ASSERT_TRUE(matrix_io::write_matrix(path_b, empty.data(), 0, 90));
+    ASSERT_TRUE(out_of_core::ab_c(path_a, path_b, path_c, path_r, config));
+    {
+        matrix_io::MappedMatrix<Matrix<70, 90>> r{path_r};
+        ASSERT_TRUE(r.valid());
+        EXPECT_EQ(r.matrix(), c);
+    }
+
+    for (const auto &path : {path_a, path_b, path_c, path_r})
+    {
+        std::filesystem::remove(path);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/* Asynchronous A . B and A . B + C */
+template <std::size_t R, std::size_t C, std::size_t C2>
+void validate_async()
+{
+    test_pool();
+
+    Matrix<R, C> a{};
+    fill_matrix<double>(a);
+    Matrix<C, C2> b{};
+    fill_matrix<double>(b);
+    Matrix<R, C2> c{};
+    fill_matrix<double>(c);
+
+    auto future_r = multiply_async(a, b);
+    auto future_r2 = ab_c_async(a, b, c);
+
+    /* the caller is free while the products run */
+    auto r_expected = a.multiplication_t1(b);
+    auto r2_expected = ab_c_optimised(a, b, c);
+
+    validate_double_matrix<R, C2>(*future_r.get(), r_expected);
+    validate_double_matrix<R, C2>(*future_r2.get(), r2_expected);
+}
+
+TEST(Async, multiply_async_ab_c_async)
+{
+    validate_async<3, 3, 3>();
+    validate_async<10, 5, 10>();
+    validate_async<120, 5, 150>();
+    validate_async<100, 100, 100>();
+}
+
+/* The chunks run on the shared pool, not on the caller; serial runs them before returning */
+TEST(Async, runs_off_the_calling_thread)
+{
+    Matrix<64, 64> a{};
+    fill_matrix<double>(a);
+    const auto expected = a.multiplication_t1(a);
+
+    const auto caller = std::this_thread::get_id();
+    std::atomic<std::size_t> on_caller{0};
+    std::vector<std::pair<std::size_t, std::size_t>> chunks{{0, 1}, {1, 2}, {2, 3}, {3, 4}};
+    std::promise<void> done{};
+    detail::run_async(
+        execution::automatic, chunks, [&on_caller, caller](std::size_t, std::size_t)
+        { on_caller += std::this_thread::get_id() == caller; },
+        [&done]()
+        { done.set_value(); });
+    done.get_future().wait();
+    EXPECT_EQ(on_caller, 0u);
+
+    validate_double_matrix<64, 64>(*multiply_async(a, a, execution::pool).get(), expected);
+    auto serial = multiply_async(a, a, execution::serial);
+    EXPECT_EQ(serial.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+    validate_double_matrix<64, 64>(*serial.get(), expected);
+
+    /* started and awaited on every worker of the shared pool at once */
+    auto &tp = execution::shared_pool();
+    std::vector<std::pair<std::size_t, std::size_t>> workers{};
+    for (std::size_t i = 0; i < tp.workers_.size(); i++)
+    {
+        workers.emplace_back(i, i + 1);
+    }
+    std::atomic<std::size_t> ready{0};
+    thread_pool::fork_join(tp, workers, [&a, &ready](std::size_t, std::size_t)
+                           {
+        auto future = multiply_async(a, a, execution::pool);
+        ready += future.wait_for(std::chrono::seconds(0)) == std::future_status::ready; },
+                           thread_pool::ForkJoin::pool_only);
+    EXPECT_EQ(ready, tp.workers_.size());
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/* Task graph: nodes run after all of their dependencies */
+TEST(TaskGraph, dependencies)
+{
+    thread_pool::TaskGraph graph{};
+    std::atomic<int> sum{0};
+    std::atomic<bool> order_ok{true};
+    auto n1 = graph.add([&sum]()
+                        { sum += 1; });
+    auto n2 = graph.add([&sum]()
+                        { sum += 2; });
+    graph.add([&sum, &order_ok]()
+              { order_ok = order_ok && (sum == 3); sum += 10; },
+              {n1, n2});
+
+    /* inline (pool not started) and on the pool, the graph can be run repeatedly */
+    thread_pool::ThreadPool no_workers{};
+    graph.run(no_workers);
+    EXPECT_EQ(sum, 13);
+    sum = 0;
+    graph.run(test_pool());
+    EXPECT_EQ(sum, 13);
+    EXPECT_EQ(graph.size(), 3u);
+    EXPECT_TRUE(order_ok);
+}
+
+/* A graph run from inside pool jobs, with every worker busy, must not wait on queued nodes */
+TEST(TaskGraph, run_on_a_worker)
+{
+    auto &tp = test_pool();
+    const auto workers = tp.workers_.size();
+    std::vector<thread_pool::TaskGraph> graphs(workers);
+    std::vector<int> sums(workers, 0);
+    for (std::size_t i = 0; i < workers; i++)
+    {
+        auto first = graphs[i].add([&sums, i]()
+                                   { sums[i] += 1; });
+        graphs[i].add([&sums, i]()
+                      { sums[i] *= 5; },
+                      {first});
+    }
+
+    std::vector<std::pair<std::size_t, std::size_t>> chunks{};
+    for (std::size_t i = 0; i < workers; i++)
+    {
+        chunks.emplace_back(i, i + 1);
+    }
+    thread_pool::fork_join(tp, chunks, [&tp, &graphs](std::size_t start, std::size_t)
+                           { graphs[start].run(tp); },
+                           thread_pool::ForkJoin::pool_only);
+    EXPECT_EQ(sums, std::vector<int>(workers, 5));
+}
+
+/* (A . B) + (C . D) and (A . B) . E + C */
+template <std::size_t N>
+void validate_matrix_graph()
+{
+    Matrix<N, N> a{}, b{}, c{}, d{}, e{};
+    fill_matrix<double>(a);
+    fill_matrix<double>(b);
+    fill_matrix<double>(c);
+    fill_matrix<double>(d);
+    fill_matrix<double>(e);
+
+    Matrix<N, N> ab{}, cd{}, r{}, r2{}, diff{};
+    thread_pool::TaskGraph graph{};
+    auto n_ab = add_multiplication(graph, ab, a, b);
+    auto n_cd = add_multiplication(graph, cd, c, d);
+    add_addition(graph, r, ab, cd, {n_ab, n_cd});
+    add_ab_c(graph, r2, ab, e, c, {n_ab});
+    add_subtraction(graph, diff, ab, cd, {n_ab, n_cd});
+    graph.run(test_pool());
+
+    validate_double_matrix<N, N>(r, (a * b) + (c * d));
+    validate_double_matrix<N, N>(r2, ((a * b) * e) + c);
+    validate_double_matrix<N, N>(diff, (a * b) - (c * d));
+}
+
+TEST(TaskGraph, matrix_expressions)
+{
+    validate_matrix_graph<3>();
+    validate_matrix_graph<10>();
+    validate_matrix_graph<64>();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/* Fork/join: the submitting thread computes chunks too */
+TEST(ForkJoin, multiplication_tn_pool_modes)
+{
+    test_pool();
+
+    Matrix<100, 60> a{};
+    fill_matrix<double>(a);
+    Matrix<60, 70> b{};
+    fill_matrix<double>(b);
+    auto r = a.multiplication_t1(b);
+
+    validate_double_matrix<100, 70>(a.multiplication_tn_pool(b), r);
+    validate_double_matrix<100, 70>(a.multiplication_tn_pool(b, thread_pool::ForkJoin::pool_only), r);
+    validate_double_matrix<100, 70>(a.multiplication_tn_pool(b, thread_pool::ForkJoin::caller_participates), r);
+    validate_double_matrix<100, 70>(a.multiplication_tn_pool(b, thread_pool::ForkJoin::inline_when_saturated), r);
+}
+
+/* Collect the ids of the threads that ran the chunks */
+inline std::vector<std::thread::id> fork_join_thread_ids(thread_pool::ThreadPool &tp, std::size_t number_of_chunks, thread_pool::ForkJoin mode)
+{
+    std::vector<std::pair<std::size_t, std::size_t>> chunks{};
+    for (std::size_t i = 0; i < number_of_chunks; i++)
+    {
+        chunks.emplace_back(i, i + 1);
+    }
+    std::vector<std::thread::id> ids(number_of_chunks);
+    thread_pool::fork_join(tp, chunks, [&ids](std::size_t start, std::size_t)
+                           {
+        ids[start] = std::this_thread::get_id();
+        std::this_thread::sleep_for(std::chrono::milliseconds(2)); },
+                           mode);
+    return ids;
+}
+
+TEST(ForkJoin, caller_participation)
+{
+    thread_pool::ThreadPool tp{};
+    tp.init(2);
+    const auto caller = std::this_thread::get_id();
+
+    /* more chunks than workers, the caller takes some of them */
+    auto ids = fork_join_thread_ids(tp, 8, thread_pool::ForkJoin::caller_participates);
+    EXPECT_NE(std::find(ids.begin(), ids.end(), caller), ids.end());
+
+    ids = fork_join_thread_ids(tp, 8, thread_pool::ForkJoin::pool_only);
+    EXPECT_EQ(std::find(ids.begin(), ids.end(), caller), ids.end());
+
+    /* saturate both workers with a job that blocks until released */
+    std::latch release{1};
+    std::vector<std::pair<std::size_t, std::size_t>> chunks{{0, 1}, {1, 2}, {2, 3}};
+    std::thread other([&tp, &release, &chunks]()
+                      { thread_pool::fork_join(tp, chunks, [&release](std::size_t, std::size_t)
+                                               { release.wait(); }); });
+    while (tp.busy_ < tp.workers_.size())
+    {
+        std::this_thread::yield();
+    }
+
+    ids = fork_join_thread_ids(tp, 4, thread_pool::ForkJoin::inline_when_saturated);
+    EXPECT_EQ(std::count(ids.begin(), ids.end(), caller), 4);
+
+    release.count_down();
+    other.join();
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/* pool_only from inside pool jobs, with every worker busy, must not wait on queued helpers */
+TEST(ForkJoin, pool_only_on_a_worker)
+{
+    thread_pool::ThreadPool tp{};
+    tp.init(2);
+    const std::vector<std::pair<std::size_t, std::size_t>> outer{{0, 1}, {1, 2}};
+    const std::vector<std::pair<std::size_t, std::size_t>> inner{{0, 1}, {1, 2}, {2, 3}, {3, 4}};
+    std::atomic<std::size_t> chunks{0};
+    thread_pool::fork_join(tp, outer, [&](std::size_t, std::size_t)
+                           { thread_pool::fork_join(tp, inner, [&chunks](std::size_t, std::size_t)
+                                                    { chunks++; },
+                                                    thread_pool::ForkJoin::pool_only); },
+                           thread_pool::ForkJoin::pool_only);
+    EXPECT_EQ(chunks, outer.size() * inner.size());
+}
+
+/* Many producers share a pool with tiny queues: no task is dropped and jobs don't mix */
+TEST(ThreadPool, concurrent_producers)
+{
+    thread_pool::ThreadPoolImpl<thread_pool::WorkerLockFree> tp{};
+    /* 2 workers, 2 queue slots each */
+    tp.init(2, std::size_t{2});
+
+    constexpr std::size_t producers{6};
+    constexpr std::size_t rounds{40};
+    constexpr std::size_t number_of_chunks{16};
+    std::vector<std::pair<std::size_t, std::size_t>> chunks{};
+    for (std::size_t i = 0; i < number_of_chunks; i++)
+    {
+        chunks.emplace_back(i, i + 1);
+    }
+
+    std::atomic<std::size_t> errors{0};
+    std::atomic<std::size_t> async_chunks{0};
+    std::vector<std::thread> threads{};
+    for (std::size_t p = 0; p < producers; p++)
+    {
+        threads.emplace_back([&, p]()
+                             {
+            for (std::size_t round = 0; round < rounds; round++)
+            {
+                /* every chunk of this job is written exactly once, by this job only */
+                std::vector<std::size_t> out(number_of_chunks, 0);
+                auto mode = round % 2 ? thread_pool::ForkJoin::pool_only : thread_pool::ForkJoin::caller_participates;
+                thread_pool::fork_join(tp, chunks, [&out, p](std::size_t start, std::size_t)
+                                       { out[start] += p + 1; },
+                                       mode);
+                errors += static_cast<std::size_t>(std::count_if(out.begin(), out.end(), [p](auto v)
+                                                                 { return v != p + 1; }));
+
+                std::latch done{1};
+                thread_pool::run_chunks_async(
+                    tp, chunks, [&async_chunks](std::size_t, std::size_t)
+                    { async_chunks++; },
+                    [&done]()
+                    { done.count_down(); });
+                done.wait();
+            } });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    EXPECT_EQ(errors, 0u);
+    EXPECT_EQ(async_chunks, producers * rounds * number_of_chunks);
+}
+
+/* Concurrent products on the shared pool */
+TEST(ThreadPool, concurrent_multiplications)
+{
+    test_pool();
+
+    Matrix<64, 48> a{};
+    fill_matrix<double>(a);
+    Matrix<48, 56> b{};
+    fill_matrix<double>(b);
+    const auto r = a.multiplication_t1(b);
+
+    std::vector<std::thread> threads{};
+    for (std::size_t p = 0; p < 4; p++)
+    {
+        threads.emplace_back([&]()
+                             {
+            for (std::size_t round = 0; round < 5; round++)
+            {
+                validate_double_matrix<64, 56>(a.multiplication_tn_pool(b), r);
+            } });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+}
+
+/* A high priority job completes on the reserved worker while bulk work holds the others */
+TEST(ThreadPool, reserved_priority_worker)
+{
+    thread_pool::ThreadPool tp{};
+    tp.reserve(1);
+    tp.init(2);
+
+    std::latch release{1};
+    std::vector<std::pair<std::size_t, std::size_t>> bulk{{0, 1}};
+    std::thread other([&tp, &release, &bulk]()
+                      { thread_pool::fork_join(tp, bulk, [&release](std::size_t, std::size_t)
+                                               { release.wait(); },
+                                               thread_pool::ForkJoin::pool_only); });
+    while (tp.busy_ < 1)
+    {
+        std::this_thread::yield();
+    }
+
+    std::vector<std::pair<std::size_t, std::size_t>> small{{0, 1}};
+    std::thread::id id{};
+    thread_pool::fork_join(tp, small, [&id](std::size_t, std::size_t)
+                           { id = std::this_thread::get_id(); },
+                           thread_pool::ForkJoin::pool_only, thread_pool::Priority::high);
+    EXPECT_NE(id, std::this_thread::get_id());
+
+    release.count_down();
+    other.join();
+}
+
+/* Queued high priority work runs before the remaining chunks of a bulk job */
+TEST(ThreadPool, priority_between_chunks)
+{
+    thread_pool::ThreadPool tp{};
+    tp.init(1);
+
+    std::latch gate{1};
+    std::latch bulk_complete{1};
+    std::atomic<std::size_t> bulk_chunks{0};
+    std::vector<std::pair<std::size_t, std::size_t>> chunks{};
+    for (std::size_t i = 0; i < 8; i++)
+    {
+        chunks.emplace_back(i, i + 1);
+    }
+    thread_pool::run_chunks_async(
+        tp, chunks, [&](std::size_t start, std::size_t)
+        {
+            if (start == 0)
+                gate.wait();
+            bulk_chunks++; },
+        [&bulk_complete]()
+        { bulk_complete.count_down(); });
+
+    std::latch high_complete{1};
+    std::size_t seen{chunks.size()};
+    tp.submit(std::make_shared<thread_pool::Task>([&]()
+                                                  {
+        seen = bulk_chunks;
+        high_complete.count_down(); }),
+              thread_pool::Priority::high);
+    gate.count_down();
+
+    high_complete.wait();
+    bulk_complete.wait();
+    EXPECT_LE(seen, 1u);
+    EXPECT_EQ(bulk_chunks, chunks.size());
+
+    auto pieces = thread_pool::split_chunks(std::vector<std::pair<std::size_t, std::size_t>>{{0, 5}, {5, 6}}, 2);
+    EXPECT_EQ(pieces, (std::vector<std::pair<std::size_t, std::size_t>>{{0, 2}, {2, 4}, {4, 5}, {5, 6}}));
+}
+
+/* Normal priority chunks are split into pieces, high priority chunks are left whole */
+TEST(ThreadPool, normal_jobs_split)
+{
+    thread_pool::ThreadPool tp{};
+    tp.init(2);
+
+    const std::vector<std::pair<std::size_t, std::size_t>> chunks{{0, 1000}};
+    auto pieces_of = [&tp, &chunks](thread_pool::Priority priority)
+    {
+        std::mutex m{};
+        std::vector<std::pair<std::size_t, std::size_t>> pieces{};
+        thread_pool::fork_join(tp, chunks, [&m, &pieces](std::size_t start, std::size_t end)
+                               {
+            std::lock_guard lock{m};
+            pieces.emplace_back(start, end); },
+                               thread_pool::ForkJoin::pool_only, priority);
+        std::sort(pieces.begin(), pieces.end());
+        return pieces;
+    };
+
+    EXPECT_EQ(pieces_of(thread_pool::Priority::high), chunks);
+    const auto pieces = pieces_of(thread_pool::Priority::normal);
+    EXPECT_EQ(pieces, thread_pool::split_chunks(chunks, 125));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/* Execution policies: every backend computes the same result */
+TEST(Execution, policies)
+{
+    Matrix<32, 24> a{};
+    fill_matrix<double>(a);
+    Matrix<24, 40> b{};
+    fill_matrix<double>(b);
+    Matrix<32, 40> c{};
+    fill_matrix<double>(c);
+    Matrix<32, 24> d{};
+    fill_matrix<double>(d);
+    const auto ab = a.multiplication_t1(b);
+    const auto ab_c_r = ab_c_optimised(a, b, c);
+    const auto a_d = a.addition(d);
+
+    Matrix<16, 16> s{};
+    fill_matrix<double>(s);
+    const auto s_vec = strassens::array_to_vec_matrix(s);
+    const auto ss = s.multiplication_t1(s);
+
+    for (const auto &policy : {execution::automatic, execution::serial, execution::threads, execution::pool, execution::omp})
+    {
+        validate_double_matrix<32, 40>(a.multiplication(b, policy), ab);
+        validate_double_matrix<32, 40>(ab_c(a, b, c, policy), ab_c_r);
+        validate_double_matrix<32, 24>(a.addition(d, policy), a_d);
+        validate_double_matrix<16, 16>(Matrix<16, 16>{strassens::vec_matrix_to_array<16, 16>(strassens::strassens_mult(s_vec, s_vec, policy))}, ss);
+        EXPECT_EQ(strassens::mat_mul(s_vec, s_vec, policy), strassens::strassens_mult(s_vec, s_vec, policy));
+    }
+}
+
+TEST(Execution, default_backend)
+{
+    EXPECT_EQ(execution::resolve(execution::serial), execution::Backend::serial);
+    EXPECT_EQ(execution::resolve(execution::automatic), execution::Backend::pool);
+
+    execution::set_default_backend(execution::Backend::omp);
+    EXPECT_EQ(execution::resolve(execution::automatic), execution::Backend::omp);
+    EXPECT_EQ(execution::resolve(execution::threads), execution::Backend::threads);
+
+    Matrix<64, 64> a{};
+    fill_matrix<double>(a);
+    validate_double_matrix<64, 64>(a * a, a.multiplication_t1(a));
+
+    execution::set_default_backend(execution::Backend::automatic);
+    EXPECT_EQ(execution::default_backend(), execution::Backend::pool);
+}
+
+/* Multiplies made from inside a parallel region or a pool task run serially */
+TEST(Execution, nested_calls_are_serial)
+{
+    EXPECT_FALSE(execution::nested());
+
+    Matrix<32, 32> a{};
+    fill_matrix<double>(a);
+    const auto r = a.multiplication_t1(a);
+
+    std::vector<std::pair<std::size_t, std::size_t>> chunks{{0, 1}, {1, 2}, {2, 3}, {3, 4}};
+    std::atomic<std::size_t> nested{0};
+    std::atomic<std::size_t> team_of_one{0};
+    execution::run(execution::threads, chunks, [&](std::size_t, std::size_t)
+                   {
+        nested += execution::nested();
+        team_of_one += execution::Team{8}.threads() == 1;
+        validate_double_matrix<32, 32>(a.multiplication_tn(a), r);
+        validate_double_matrix<32, 32>(a.multiplication_omp(a), r); });
+    EXPECT_EQ(nested, chunks.size());
+    EXPECT_EQ(team_of_one, chunks.size());
+
+    std::latch done{1};
+    bool worker_nested{false};
+    test_pool().submit(std::make_shared<thread_pool::Task>([&]()
+                                                           {
+        worker_nested = execution::nested();
+        validate_double_matrix<32, 32>(a * a, r);
+        done.count_down(); }));
+    done.wait();
+    EXPECT_TRUE(worker_nested);
+    EXPECT_FALSE(execution::nested());
+}
+
+/* Concurrent operations share the global thread budget */
+TEST(Execution, thread_budget)
+{
+    const auto budget = execution::thread_budget();
+    execution::set_thread_budget(3);
+    {
+        execution::Team first{8};
+        EXPECT_EQ(first.threads(), 4u);
+        execution::Team second{8};
+        EXPECT_EQ(second.threads(), 1u);
+
+        /* no threads left, the operation still completes on the caller */
+        Matrix<32, 32> a{};
+        fill_matrix<double>(a);
+        Matrix<32, 32> c{};
+        fill_matrix<double>(c);
+        validate_double_matrix<32, 32>(a.multiplication_tn(a), a.multiplication_t1(a));
+        validate_double_matrix<32, 32>(ab_c_optimised_tn(a, a, c), ab_c_optimised(a, a, c));
+        validate_double_matrix<32, 32>(ab_c_omp(a, a, c), ab_c_optimised(a, a, c));
+    }
+    execution::Team third{2};
+    EXPECT_EQ(third.threads(), 2u);
+
+    execution::set_thread_budget(budget);
+}
+
+/* The default pool is sized from the hardware and its idle workers park instead of spinning */
+TEST(Execution, idle_pool_parks)
+{
+    EXPECT_LE(execution::shared_pool().workers_.size(), std::max<std::size_t>(std::thread::hardware_concurrency(), 1));
+
+    Matrix<64, 64> a{};
+    fill_matrix<double>(a);
+    validate_double_matrix<64, 64>(a.multiplication(a, execution::pool), a.multiplication_t1(a));
+
+    /* process CPU time while the caller sleeps, the workers are done spinning within a few microseconds */
+    const auto cpu = std::clock();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    const auto used = static_cast<double>(std::clock() - cpu) / CLOCKS_PER_SEC;
+    EXPECT_LT(used, 0.05);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/* Cancellation: stopped or expired operations report it instead of returning a partial result */
+TEST(Cancellation, multiplication_and_ab_c)
+{
+    Matrix<64, 48> a{};
+    fill_matrix<double>(a);
+    Matrix<48, 40> b{};
+    fill_matrix<double>(b);
+    Matrix<64, 40> c{};
+    fill_matrix<double>(c);
+    Matrix<64, 40> r{};
+
+    for (const auto &policy : {execution::serial, execution::threads, execution::pool, execution::omp})
+    {
+        auto outcome = a.multiplication(r, b, execution::Cancellation{}, policy);
+        EXPECT_TRUE(outcome.ok());
+        EXPECT_EQ(outcome.completed, outcome.total);
+        validate_double_matrix<64, 40>(r, a.multiplication_t1(b));
+
+        outcome = ab_c(r, a, b, c, execution::with_timeout(std::chrono::hours(1)), policy);
+        EXPECT_TRUE(outcome.ok());
+        validate_double_matrix<64, 40>(r, ab_c_optimised(a, b, c));
+    }
+
+    /* stopped before the first block, the result is not written */
+    Matrix<64, 40> untouched{};
+    for (auto &row : untouched.data())
+    {
+        row.fill(7.0);
+    }
+    r = untouched;
+    std::stop_source source{};
+    source.request_stop();
+    auto outcome = a.multiplication(r, b, execution::Cancellation{source.get_token()}, execution::pool);
+    EXPECT_EQ(outcome.status, execution::Status::cancelled);
+    EXPECT_EQ(outcome.completed, 0u);
+    EXPECT_EQ(r, untouched);
+
+    outcome = ab_c(r, a, b, c, execution::with_timeout(std::chrono::seconds(-1)));
+    EXPECT_EQ(outcome.status, execution::Status::deadline_exceeded);
+    EXPECT_FALSE(outcome.ok());
+    EXPECT_EQ(r, untouched);
+}
+
+TEST(Cancellation, stops_between_blocks)
+{
+    std::stop_source source{};
+    std::vector<std::pair<std::size_t, std::size_t>> chunks{{0, 64}};
+    std::size_t blocks{0};
+    auto outcome = execution::run(
+        execution::serial, chunks, [&](std::size_t, std::size_t)
+        {
+            /* the client gives up while the second block runs */
+            if (++blocks == 2)
+                source.request_stop(); },
+        execution::Cancellation{source.get_token(), execution::Cancellation::Clock::time_point::max(), 8});
+
+    EXPECT_EQ(outcome.status, execution::Status::cancelled);
+    EXPECT_EQ(outcome.completed, 2u);
+    EXPECT_EQ(outcome.total, 8u);
+    EXPECT_EQ(blocks, 2u);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/* Aligned and huge page backed buffers */
+TEST(Allocator, aligned_buffers)
+{
+    for (auto pages : {memory::Pages::normal, memory::Pages::transparent_huge, memory::Pages::explicit_huge})
+    {
+        for (std::size_t bytes : {std::size_t{8}, std::size_t{1000}, memory::huge_page_size + 24})
+        {
+            auto *ptr = memory::allocate(bytes, pages);
+            ASSERT_NE(ptr, nullptr);
+            EXPECT_TRUE(memory::is_aligned(ptr));
+            std::memset(ptr, 1, bytes);
+            memory::deallocate(ptr, bytes, pages);
+        }
+    }
+
+    /* large transparent huge page buffers start on a huge page boundary */
+    auto *ptr = memory::allocate(4 * memory::huge_page_size, memory::Pages::transparent_huge);
+    EXPECT_TRUE(memory::is_aligned(ptr, memory::huge_page_size));
+    memory::deallocate(ptr, 4 * memory::huge_page_size, memory::Pages::transparent_huge);
+
+    memory::AlignedVector<double, memory::Pages::transparent_huge> v(300000, 1.0);
+    EXPECT_TRUE(memory::is_aligned(v.data()));
+    v.resize(10);
+    v.shrink_to_fit();
+    EXPECT_TRUE(memory::is_aligned(v.data()));
+}
+
+TEST(Allocator, make_matrix)
+{
+    auto a = memory::make_matrix<Matrix<256, 256>>();
+    auto b = memory::make_matrix<Matrix<256, 256>>(memory::Pages::explicit_huge);
+    auto r = memory::make_matrix<Matrix<256, 256>>(memory::Pages::normal);
+    ASSERT_TRUE(a && b && r);
+    EXPECT_TRUE(memory::is_aligned(&a->data()[0][0]));
+    EXPECT_TRUE(memory::is_aligned(&r->data()[0][0]));
+    EXPECT_EQ(*r, (Matrix<256, 256>{}));
+
+    fill_matrix<double>(*a);
+    fill_matrix<double>(*b);
+    a->multiplication_t_aux(*r, *b, 0, a->rows());
+    validate_double_matrix<256, 256>(*r, a->multiplication(*b, execution::serial));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/* Thread local scratch arena */
+TEST(Arena, checkpoint_and_rewind)
+{
+    memory::ScratchArena arena{1024};
+    auto *a = arena.allocate<double>(3);
+    EXPECT_TRUE(memory::is_aligned(a));
+    EXPECT_EQ(arena.used(), memory::cache_line_size);
+    {
+        memory::ScratchArena::Scope scope{arena};
+        auto *b = arena.allocate<double>(100);
+        auto *c = arena.allocate<double>(200);
+        EXPECT_TRUE(memory::is_aligned(b));
+        EXPECT_TRUE(memory::is_aligned(c));
+        EXPECT_EQ(arena.blocks(), 2u);
+    }
+    EXPECT_EQ(arena.used(), memory::cache_line_size);
+    EXPECT_GE(arena.high_water(), 1024u + 1600u);
+
+    /* the blocks are reused after a rewind */
+    (void)arena.allocate<double>(100);
+    (void)arena.allocate<double>(200);
+    EXPECT_EQ(arena.blocks(), 2u);
+}
+
+TEST(Arena, strassen_steady_state)
+{
+    auto a = memory::make_matrix<Matrix<128, 128>>();
+    auto b = memory::make_matrix<Matrix<128, 128>>();
+    auto r = memory::make_matrix<Matrix<128, 128>>();
+    auto e = memory::make_matrix<Matrix<128, 128>>();
+    fill_matrix<int>(*a);
+    fill_matrix<int>(*b);
+    a->multiplication_t_aux(*e, *b, 0, a->rows());
+
+    /* warm up, the arenas grow to the working set */
+    strassens::multiply(*r, *a, *b);
+    validate_double_matrix<128, 128>(*r, *e);
+
+    const auto allocations = memory::arena_counters().system_allocations.load();
+    for (int i = 0; i < 5; i++)
+    {
+        strassens::multiply(*r, *a, *b);
+    }
+    EXPECT_EQ(memory::arena_counters().system_allocations.load(), allocations);
+    validate_double_matrix<128, 128>(*r, *e);
+
+    for (auto policy : {execution::pool, execution::omp, execution::threads})
+    {
+        r->data()[0].fill(0.0);
+        strassens::multiply(*r, *a, *b, policy);
+        validate_double_matrix<128, 128>(*r, *e);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/* Right hand operand packed once */
+template <std::size_t R, std::size_t C, std::size_t C2>
+void validate_packed_matrix()
+{
+    Matrix<R, C> a{};
+    Matrix<C, C2> b{};
+    Matrix<R, C2> c{};
+    fill_matrix<double>(a);
+    fill_matrix<double>(b);
+    fill_matrix<double>(c);
+    const auto r = a.multiplication_t1(b);
+    const auto r_c = r + c;
+
+    for (auto packing : {Packing::panels, Packing::transposed})
+    {
+        const PackedMatrix<double, C, C2> packed{b, packing};
+        validate_double_matrix<R, C2>(a * packed, r);
+        for (auto policy : {execution::serial, execution::threads, execution::pool, execution::omp})
+        {
+            validate_double_matrix<R, C2>(multiplication(a, packed, policy), r);
+            validate_double_matrix<R, C2>(ab_c(a, packed, c, policy), r_c);
+        }
+    }
+}
+
+TEST(Packed, multiplication_and_ab_c)
+{
+    validate_packed_matrix<16, 16, 16>();
+    validate_packed_matrix<100, 100, 100>();
+    /* partial panels and row blocks */
+    validate_packed_matrix<13, 21, 19>();
+    validate_packed_matrix<9, 5, 7>();
+    validate_packed_matrix<3, 10, 1>();
+}
+
+TEST(Packed, repack)
+{
+    Matrix<32, 32> a{};
+    Matrix<32, 32> b{};
+    fill_matrix<double>(a);
+    fill_matrix<double>(b);
+    PackedMatrix<double, 32, 32> packed{b, Packing::transposed};
+
+    b = b * 2.0;
+    packed.pack(b);
+    EXPECT_EQ(packed.packing(), Packing::transposed);
+    validate_double_matrix<32, 32>(a * packed, a.multiplication_t1(b));
+
+    packed.pack(b, Packing::panels);
+    validate_double_matrix<32, 32>(a * packed, a.multiplication_t1(b));
+
+    /* not packed yet, B = 0 */
+    const PackedMatrix<double, 32, 32> empty{};
+    validate_double_matrix<32, 32>(a * empty, Matrix<32, 32>{});
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/* R = A . B + C maintained incrementally */
+TEST(Incremental, matches_full_product)
+{
+    Matrix<40, 30> a{};
+    Matrix<30, 20> b{};
+    Matrix<40, 20> c{};
+    fill_matrix<double>(a);
+    fill_matrix<double>(b);
+    fill_matrix<double>(c);
+    IncrementalProduct product{a, b, c, execution::serial};
+    validate_double_matrix<40, 20>(product.result(), ab_c_optimised(a, b, c));
+
+    for (auto policy : {execution::serial, execution::pool, execution::threads})
+    {
+        Matrix<40, 30> a_rows{};
+        Matrix<30, 20> b_rows{};
+        fill_matrix<double>(a_rows);
+        fill_matrix<double>(b_rows);
+
+        product.set_a_row(3, a_rows.data()[0]);
+        product.set_a(17, 5, 2.5);
+        product.set_b_row(7, b_rows.data()[1]);
+        product.set_b(7, 2, -1.0);
+        product.set_b(12, 19, 4.0);
+        product.set_b_column(4, a_rows.data()[2]);
+        product.set_c(3, 1, 8.0);
+        product.set_c(30, 0, -3.0);
+        product.set_c(30, 0, 5.0);
+        EXPECT_TRUE(product.pending());
+        product.update(policy);
+        EXPECT_FALSE(product.pending());
+
+        a = product.a();
+        b = product.b();
+        c = product.c();
+        validate_double_matrix<40, 20>(product.result(), ab_c_optimised(a, b, c));
+    }
+
+    /* more changes than a full product is worth */
+    Matrix<40, 30> a_new{};
+    fill_matrix<double>(a_new);
+    for (std::size_t i = 0; i < 40; i++)
+    {
+        product.set_a_row(i, a_new.data()[i]);
+    }
+    product.update();
+    validate_double_matrix<40, 20>(product.result(), ab_c_optimised(a_new, b, c));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/* Sliding window Gram matrix and covariance */
+TEST(StreamingGram, sliding_window)
+{
+    constexpr std::size_t window = 20;
+    Matrix<100, 6> stream{};
+    fill_matrix<double>(stream);
+
+    /* X^T . X and covariance of rows [end - window, end) computed directly */
+    auto validate = [&stream](const StreamingGram<double, 6> &gram, std::size_t end)
+    {
+        const auto begin = end > window ? end - window : 0;
+        const auto n = static_cast<double>(end - begin);
+        ASSERT_EQ(gram.size(), end - begin);
+        Matrix<6, 6> expected{};
+        Matrix<6, 6> covariance{};
+        std::array<double, 6> mean{};
+        for (std::size_t r = begin; r < end; r++)
+        {
+            for (std::size_t i = 0; i < 6; i++)
+            {
+                mean[i] += stream.data()[r][i] / n;
+                for (std::size_t j = 0; j < 6; j++)
+                {
+                    expected.data()[i][j] += stream.data()[r][i] * stream.data()[r][j];
+                }
+            }
+        }
+        for (std::size_t r = begin; r < end; r++)
+        {
+            for (std::size_t i = 0; i < 6; i++)
+            {
+                for (std::size_t j = 0; j < 6; j++)
+                {
+                    covariance.data()[i][j] += (stream.data()[r][i] - mean[i]) * (stream.data()[r][j] - mean[j]) / (n - 1);
+                }
+            }
+        }
+        validate_double_matrix<6, 6>(gram.gram(), expected);
+        validate_double_matrix<6, 6>(gram.covariance(), covariance);
+        for (std::size_t i = 0; i < 6; i++)
+        {
+            EXPECT_NEAR(gram.mean()[i], mean[i], 0.0000001);
+        }
+    };
+
+    StreamingGram<double, 6> single{window};
+    for (std::size_t r = 0; r < 60; r++)
+    {
+        single.push(stream.data()[r]);
+        if (r > 0)
+            validate(single, r + 1);
+    }
+    single.recompute();
+    validate(single, 60);
+
+    /* micro-batches, including one larger than the window */
+    StreamingGram<double, 6> batched{window};
+    std::size_t end{0};
+    for (std::size_t count : {3, 7, 15, 1, 9, 25, 4})
+    {
+        batched.push(stream.data()[end].data(), count);
+        end += count;
+        validate(batched, end);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/* Symmetric rank k update */
+template <std::size_t R, std::size_t C>
+void validate_syrk()
+{
+    Matrix<R, C> a{};
+    fill_matrix<double>(a);
+    Matrix<C, R> a_t{};
+    for (std::size_t i = 0; i < R; i++)
+    {
+        for (std::size_t j = 0; j < C; j++)
+        {
+            a_t.data()[j][i] = a.data()[i][j];
+        }
+    }
+    const auto a_a_t = a.multiplication_t1(a_t);
+    const auto a_t_a = a_t.multiplication_t1(a);
+
+    for (auto policy : {execution::serial, execution::pool, execution::threads})
+    {
+        for (auto triangle : {Triangle::upper, Triangle::lower})
+        {
+            /* R = 2 A . A^T + 0.5 R, the other triangle stays at 1 */
+            Matrix<R, R> r{};
+            Matrix<R, R> expected{};
+            for (std::size_t i = 0; i < R; i++)
+            {
+                r.data()[i].fill(1.0);
+                for (std::size_t j = 0; j < R; j++)
+                {
+                    const bool inside = triangle == Triangle::upper ? j >= i : j <= i;
+                    expected.data()[i][j] = inside ? 2.0 * a_a_t.data()[i][j] + 0.5 : 1.0;
+                }
+            }
+            syrk(r, a, triangle, 2.0, 0.5, policy);
+            validate_double_matrix<R, R>(r, expected);
+
+            Matrix<C, C> g{};
+            syrk_transposed(g, a, triangle, 1.0, 0.0, policy);
+            for (std::size_t i = 0; i < C; i++)
+            {
+                for (std::size_t j = 0; j < C; j++)
+                {
+                    const bool inside = triangle == Triangle::upper ? j >= i : j <= i;
+                    EXPECT_NEAR(g.data()[i][j], inside ? a_t_a.data()[i][j] : 0.0, 0.0000001);
+                }
+            }
+        }
+
+        SymmetricMatrix<double, R> packed{};
+        syrk(packed, a, 1.0, 0.0, policy);
+        Matrix<R, R> full{};
+        packed.to_matrix(full);
+        validate_double_matrix<R, R>(full, a_a_t);
+
+        SymmetricMatrix<double, C> packed_gram{};
+        syrk_transposed(packed_gram, a, 1.0, 0.0, policy);
+        Matrix<C, C> full_gram{};
+        packed_gram.to_matrix(full_gram);
+        validate_double_matrix<C, C>(full_gram, a_t_a);
+    }
+}
+
+TEST(Syrk, triangles_and_packed)
+{
+    validate_syrk<16, 16>();
+    validate_syrk<37, 20>();
+    validate_syrk<5, 64>();
+}
+
+TEST(Syrk, packed_storage)
+{
+    EXPECT_EQ((SymmetricMatrix<double, 10>::packed_size), 55u);
+    Matrix<10, 10> m{};
+    fill_matrix<double>(m);
+    const SymmetricMatrix<double, 10> s{m};
+    for (std::size_t i = 0; i < 10; i++)
+    {
+        for (std::size_t j = i; j < 10; j++)
+        {
+            EXPECT_EQ(s(i, j), m.data()[i][j]);
+            EXPECT_EQ(s(j, i), m.data()[i][j]);
+        }
+    }
+    EXPECT_EQ((SymmetricMatrix<double, 10>::index(9, 9)), 54u);
+
+    /* bands of the triangle hold about the same number of elements */
+    const auto chunks = detail::triangular_chunks(1000, Triangle::upper, 8);
+    ASSERT_EQ(chunks.size(), 8u);
+    EXPECT_EQ(chunks.back().second, 1000u);
+    for (const auto &[start, end] : chunks)
+    {
+        const auto area = (end - start) * (2000 - start - end + 1) / 2;
+        EXPECT_NEAR(static_cast<double>(area), 1000.0 * 1001 / 2 / 8, 1000.0);
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/* Blocked LU with partial pivoting */
+template <std::size_t N>
+void validate_lu(const execution::Policy &policy)
+{
+    Matrix<N, N> a{};
+    Matrix<N, 3> b{};
+    fill_matrix<double>(a);
+    fill_matrix<double>(b);
+
+    auto lu = a;
+    Pivots<N> ipiv{};
+    ASSERT_TRUE(getrf(lu, ipiv, policy));
+    auto x = b;
+    getrs(lu, ipiv, x, policy);
+    /* residual A . X - B */
+    validate_double_matrix<N, 3>(a.multiplication_t1(x), b);
+
+    Matrix<N, N> a_inverse{};
+    ASSERT_TRUE(inverse(a, a_inverse, policy));
+    Matrix<N, N> identity{};
+    for (std::size_t i = 0; i < N; i++)
+    {
+        identity.data()[i][i] = 1.0;
+    }
+    validate_double_matrix<N, N>(a.multiplication_t1(a_inverse), identity);
+}
+
+TEST(LU, solve_and_inverse)
+{
+    validate_lu<7>(execution::serial);
+    validate_lu<64>(execution::serial);
+    validate_lu<100>(execution::serial);
+    validate_lu<150>(execution::pool);
+    validate_lu<150>(execution::threads);
+}
+
+TEST(LU, determinant_and_singular)
+{
+    /* det(P . L . U) with a known value: rows of an upper triangular matrix swapped once */
+    Matrix<3, 3> a{{{{0.0, 4.0, 5.0}, {2.0, 1.0, 3.0}, {0.0, 0.0, 6.0}}}};
+    EXPECT_NEAR(determinant(a), -48.0, 0.0000001);
+    EXPECT_NEAR(determinant(Matrix<3, 3>{{{{2.0, 0.0, 0.0}, {0.0, 3.0, 0.0}, {0.0, 0.0, 4.0}}}}), 24.0, 0.0000001);
+
+    /* a zero column gives an exact zero pivot, equal rows one within the tolerance */
+    Matrix<70, 70> singular{};
+    fill_matrix<double>(singular);
+    for (auto &row : singular.data())
+    {
+        row[40] = 0.0;
+    }
+    Matrix<70, 70> r{};
+    EXPECT_FALSE(inverse(singular, r));
+    EXPECT_NEAR(determinant(singular), 0.0, 0.0000001);
+
+    fill_matrix<double>(singular);
+    singular.data()[69] = singular.data()[3];
+    for (const auto &policy : {execution::serial, execution::pool})
+    {
+        EXPECT_FALSE(inverse(singular, r, policy));
+    }
+
+    /* dynamic size, flat row major buffers with a leading dimension */
+    constexpr std::size_t n = 130;
+    constexpr std::size_t lda = 133;
+    Matrix<n, n> m{};
+    fill_matrix<double>(m);
+    std::vector<double> flat(n * lda, 0.0);
+    for (std::size_t i = 0; i < n; i++)
+    {
+        std::copy(m.data()[i].begin(), m.data()[i].end(), flat.begin() + i * lda);
+    }
+    EXPECT_NEAR(determinant(flat.data(), n, lda) / determinant(m), 1.0, 0.0000001);
+    std::vector<double> flat_inverse(n * n);
+    ASSERT_TRUE(inverse(flat.data(), n, lda, flat_inverse.data(), n, execution::pool));
+    Matrix<n, n> m_inverse{};
+    ASSERT_TRUE(inverse(m, m_inverse, execution::serial));
+    for (std::size_t i = 0; i < n; i++)
+    {
+        for (std::size_t j = 0; j < n; j++)
+        {
+            EXPECT_NEAR(flat_inverse[i * n + j], m_inverse.data()[i][j], 0.0000001);
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/* Blocked Cholesky and triangular solves */
+template <std::size_t N>
+void validate_cholesky(const execution::Policy &policy)
+{
+    /* A = M . M^T + N . I is symmetric positive definite */
+    Matrix<N, N> m{};
+    fill_matrix<double>(m);
+    Matrix<N, N> a{};
+    syrk(a, m, Triangle::upper, 1.0, 0.0, execution::serial);
+    syrk(a, m, Triangle::lower, 1.0, 0.0, execution::serial);
+    for (std::size_t i = 0; i < N; i++)
+    {
+        a.data()[i][i] += static_cast<double>(N);
+    }
+
+    auto l = a;
+    ASSERT_TRUE(potrf(l, policy));
+    /* L . L^T == A, the upper triangle of l still holds A */
+    Matrix<N, N> lower{};
+    Matrix<N, N> lower_t{};
+    for (std::size_t i = 0; i < N; i++)
+    {
+        for (std::size_t j = 0; j <= i; j++)
+        {
+            lower.data()[i][j] = l.data()[i][j];
+            lower_t.data()[j][i] = l.data()[i][j];
+        }
+        for (std::size_t j = i + 1; j < N; j++)
+        {
+            EXPECT_EQ(l.data()[i][j], a.data()[i][j]);
+        }
+    }
+    validate_double_matrix<N, N>(lower.multiplication_t1(lower_t), a);
+
+    Matrix<N, 5> b{};
+    fill_matrix<double>(b);
+    auto x = b;
+    potrs(l, x, policy);
+    validate_double_matrix<N, 5>(a.multiplication_t1(x), b);
+
+    auto y = b;
+    trsm(l, y, Transpose::no, policy);
+    validate_double_matrix<N, 5>(lower.multiplication_t1(y), b);
+    y = b;
+    trsm(l, y, Transpose::yes, policy);
+    validate_double_matrix<N, 5>(lower_t.multiplication_t1(y), b);
+}
+
+TEST(Cholesky, factorisation_and_solve)
+{
+    validate_cholesky<5>(execution::serial);
+    validate_cholesky<64>(execution::pool);
+    validate_cholesky<150>(execution::serial);
+    validate_cholesky<150>(execution::pool);
+    validate_cholesky<150>(execution::threads);
+    validate_cholesky<200>(execution::omp);
+}
+
+TEST(Cholesky, not_positive_definite)
+{
+    Matrix<130, 130> a{};
+    for (std::size_t i = 0; i < 130; i++)
+    {
+        a.data()[i][i] = i == 100 ? -1.0 : 2.0;
+    }
+    for (auto policy : {execution::serial, execution::pool})
+    {
+        auto l = a;
+        EXPECT_FALSE(potrf(l, policy));
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/* A^n by squaring and A^n . x by repeated GEMV */
+TEST(Power, matrix_and_vector)
+{
+    /* row stochastic (Markov chain), the powers stay bounded */
+    Matrix<48, 48> a{};
+    fill_matrix<double>(a);
+    for (auto &row : a.data())
+    {
+        double sum{0};
+        for (auto &value : row)
+        {
+            value = std::abs(value);
+            sum += value;
+        }
+        for (auto &value : row)
+        {
+            value /= sum;
+        }
+    }
+    Matrix<48, 1> x{};
+    fill_matrix<double>(x);
+
+    PowerWorkspace<double, 48> workspace{};
+    Matrix<48, 48> expected{};
+    for (std::size_t i = 0; i < 48; i++)
+    {
+        expected.data()[i][i] = 1.0;
+    }
+    for (std::size_t n = 0; n <= 33; n++)
+    {
+        Matrix<48, 48> r{};
+        pow(r, a, n, workspace, n % 2 ? execution::serial : execution::pool);
+        validate_double_matrix<48, 48>(r, expected);
+
+        Matrix<48, 1> y{};
+        pow_gemv(y, a, n, x, execution::serial);
+        validate_double_matrix<48, 1>(y, expected.multiplication_t1(x));
+
+        expected = expected.multiplication_t1(a);
+    }
+
+    Matrix<48, 48> r{};
+    pow(r, a, 1000);
+    Matrix<48, 1> y{};
+    pow_gemv(y, a, 1000, x, execution::threads);
+    validate_double_matrix<48, 1>(y, r.multiplication_t1(x));
+}
+
+/* 1100 x 1100 doubles are more than the 8 MB of a default stack, nothing may be a stack temporary */
+TEST(Power, larger_than_the_stack)
+{
+    constexpr std::size_t n = 1100;
+    auto a = memory::make_matrix<Matrix<n, n>>();
+    auto r = memory::make_matrix<Matrix<n, n>>();
+    ASSERT_TRUE(a && r);
+    for (std::size_t i = 0; i < n; i++)
+    {
+        a->data()[i].fill(0.0);
+        a->data()[i][i] = 2.0;
+        r->data()[i].fill(5.0);
+    }
+
+    PowerWorkspace<double, n> workspace{};
+    for (std::size_t power = 0; power <= 2; power++)
+    {
+        pow(*r, *a, power, workspace);
+        const auto diagonal = static_cast<double>(1 << power);
+        for (std::size_t i = 0; i < n; i += 37)
+        {
+            EXPECT_EQ(r->data()[i][i], diagonal);
+            EXPECT_EQ(r->data()[i][(i + 1) % n], 0.0);
+        }
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////
+
+/* Semiring products */
+template <typename T>
+void validate_shortest_paths()
+{
+    constexpr std::size_t n = 37;
+    using S = MinPlus<T>;
+    constexpr auto none = S::zero();
+    std::mt19937 rng{7};
+    std::uniform_real_distribution<double> dist(0, 10);
+
+    /* sparse random graph, weight of edge i -> j or none */
+    MatrixImpl<T, n, n> d{};
+    for (std::size_t i = 0; i < n; i++)
+    {
+        for (std::size_t j = 0; j < n; j++)
+        {
+            const auto w = dist(rng);
+            d.data()[i][j] = i == j ? T{0} : (w < 2.0 ? static_cast<T>(w * 5) : none);
+        }
+    }
+
+    /* Floyd-Warshall */
+    auto expected = d;
+    for (std::size_t k = 0; k < n; k++)
+    {
+        for (std::size_t i = 0; i < n; i++)
+        {
+            for (std::size_t j = 0; j < n; j++)
+            {
+                expected.data()[i][j] = S::add(expected.data()[i][j], S::multiply(expected.data()[i][k], expected.data()[k][j]));
+            }
+        }
+    }
+
+    /* D^(2^6) over (min, +) covers every path of up to 64 edges */
+    auto paths = d;
+    for (int step = 0; step < 6; step++)
+    {
+        paths = multiply<S>(paths, paths, step % 2 ? execution::serial : execution::pool);
+    }
+    for (std::size_t i = 0; i < n; i++)
+    {
+        for (std::size_t j = 0; j < n; j++)
+        {
+            if (expected.data()[i][j] == none)
+                EXPECT_EQ(paths.data()[i][j], none);
+            else
+                EXPECT_NEAR(paths.data()[i][j], expected.data()[i][j], 0.001);
+        }
+    }
+    EXPECT_EQ((multiply<S>(semiring_identity<S, n>(), d)), d);
+
+    /* a missing edge stays missing next to a negative weight */
+    EXPECT_EQ(S::multiply(none, T{-1}), none);
+    EXPECT_EQ(S::multiply(T{-1}, none), none);
+}
+
+TEST(Semiring, min_plus_shortest_paths)
+{
+    validate_shortest_paths<double>();
+    validate_shortest_paths<float>();
+    validate_shortest_paths<int>();
+}
+
+TEST(Semiring, plus_times_max_plus_and_reachability)
+{
+    Matrix<20, 30> a{};
+    Matrix<30, 25> b{};
+    fill_matrix<double>(a);
+    fill_matrix<double>(b);
+    validate_double_matrix<20, 25>(multiply<PlusTimes<double>>(a, b, execution::threads), a.multiplication_t1(b));
+
+    const auto longest = multiply<MaxPlus<double>>(a, b);
+    for (std::size_t i = 0; i < 20; i++)
+    {
+        for (std::size_t j = 0; j < 25; j++)
+        {
+            double best = MaxPlus<double>::zero();
+            for (std::size_t k = 0; k < 30; k++)
+            {
+                best = std::max(best, a.data()[i][k] + b.data()[k][j]);
+            }
+            EXPECT_EQ(longest.data()[i][j], best);
+        }
+    }
+
+    /* a chain 0 -> 1 -> ... -> 9, reachability within 2^k steps */
+    MatrixImpl<bool, 10, 10> edges = semiring_identity<OrAnd<>, 10>();
+    for (std::size_t i = 0; i + 1 < 10; i++)
+    {
+        edges.data()[i][i + 1] = true;
+    }
+    auto reach = edges;
+    for (int step = 0; step < 4; step++)
+    {
+        reach = multiply<OrAnd<>>(reach, reach);
+    }
+    for (std::size_t i = 0; i < 10; i++)
+    {
+        for (std::size_t j = 0; j < 10; j++)
+        {
+            EXPECT_EQ(reach.data()[i][j], j >= i);
+        }
+    }
+}
+
+template <std::size_t R, std::size_t C, std::size_t C2>
+void validate_bit_product()
+{
+    std::mt19937 rng{11};
+    std::bernoulli_distribution edge{0.1};
+    MatrixImpl<bool, R, C> a{};
+    MatrixImpl<bool, C, C2> b{};
+    for (auto &row : a.data())
+    {
+        for (auto &element : row)
+            element = edge(rng);
+    }
+    for (auto &row : b.data())
+    {
+        for (auto &element : row)
+            element = edge(rng);
+    }
+
+    const BitMatrix<R, C> bits_a{a};
+    const BitMatrix<C, C2> bits_b{b};
+    MatrixImpl<bool, R, C> round_trip{};
+    bits_a.to_matrix(round_trip);
+    EXPECT_EQ(round_trip, a);
+
+    const auto expected = multiply<OrAnd<>>(a, b);
+    for (const auto &policy : {execution::serial, execution::threads, execution::pool})
+    {
+        BitMatrix<R, C2> product{};
+        multiply(product, bits_a, bits_b, policy);
+        MatrixImpl<bool, R, C2> result{};
+        product.to_matrix(result);
+        EXPECT_EQ(result, expected);
+    }
+    EXPECT_EQ((bits_a * bits_b).count(), (BitMatrix<R, C2>{expected}.count()));
+}
+
+TEST(BitMatrix, product_matches_or_and)
+{
+    /* sizes that are not multiples of the word, group and block widths */
+    validate_bit_product<70, 130, 600>();
+    /* one block of columns, the rows of R are split */
+    validate_bit_product<2100, 130, 200>();
+}
+
+TEST(BitMatrix, transitive_closure)
+{
+    /* two chains 0 -> ... -> 99 and 100 -> ... -> 199 */
+    BitMatrix<200, 200> graph{};
+    for (std::size_t i = 0; i + 1 < 200; i++)
+    {
+        if (i != 99)
+            graph.set(i, i + 1);
+    }
+    BitMatrix<200, 200> reach{};
+    transitive_closure(reach, graph);
+    for (std::size_t i = 0; i < 200; i++)
+    {
+        for (std::size_t j = 0; j < 200; j++)
+        {
+            EXPECT_EQ(reach.get(i, j), j >= i && i / 100 == j / 100);
+        }
+    }
+    EXPECT_EQ(reach.count(), 2u * 100 * 101 / 2);
+}
+
+TEST(Complex, three_m_and_four_m_match_complex_product)
+{
+    std::mt19937 rng{5};
+    std::uniform_real_distribution<double> value{-1.0, 1.0};
+    MatrixImpl<std::complex<double>, 40, 30> a{};
+    MatrixImpl<std::complex<double>, 30, 50> b{};
+    for (auto &row : a.data())
+    {
+        for (auto &element : row)
+            element = {value(rng), value(rng)};
+    }
+    for (auto &row : b.data())
+    {
+        for (auto &element : row)
+            element = {value(rng), value(rng)};
+    }
+
+    const SplitComplexMatrix<double, 40, 30> split_a{a};
+    const SplitComplexMatrix<double, 30, 50> split_b{b};
+    MatrixImpl<std::complex<double>, 40, 30> round_trip{};
+    split_a.to_matrix(round_trip);
+    EXPECT_EQ(round_trip, a);
+
+    for (auto method : {ComplexMethod::four_m, ComplexMethod::three_m})
+    {
+        for (const auto &policy : {execution::serial, execution::pool})
+        {
+            SplitComplexMatrix<double, 40, 50> product{};
+            multiply(product, split_a, split_b, method, policy);
+            for (std::size_t i = 0; i < 40; i++)
+            {
+                for (std::size_t j = 0; j < 50; j++)
+                {
+                    std::complex<double> expected{};
+                    for (std::size_t k = 0; k < 30; k++)
+                    {
+                        expected += a.data()[i][k] * b.data()[k][j];
+                    }
+                    EXPECT_NEAR(product(i, j).real(), expected.real(), 1e-12);
+                    EXPECT_NEAR(product(i, j).imag(), expected.imag(), 1e-12);
+                }
+            }
+        }
+    }
+}